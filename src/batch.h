@@ -0,0 +1,297 @@
+#include "statistics.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#ifndef BATCH
+#define BATCH
+
+inline constexpr uint_fast64_t gamesPerChunk = 4096;
+inline constexpr const char* checkpointHeader = "pandemic-checkpoint 4";
+inline constexpr const char* resultHeader = "pandemic-result 5";
+
+// Progress of a run of a policy over the games seeded firstSeed .. firstSeed +
+// games - 1, set up with a sampling bias. Every game draws only from an engine
+// seeded with its own seed, so the set of completed chunks is the complete
+// random stream position of the run.
+class Checkpoint
+{
+    private:
+
+        uint_fast64_t firstSeed;
+        uint_fast64_t games;
+        std::string policy;
+        SamplingBias bias;
+        std::vector<bool> completedChunks;
+
+    public:
+
+        GameStatistics statistics;
+
+        Checkpoint(uint_fast64_t first, uint_fast64_t count, std::string policyName = PassivePolicy::name, const SamplingBias& b = SamplingBias{})
+            : firstSeed{first}, games{count}, policy{std::move(policyName)}, bias{b}, completedChunks((count + gamesPerChunk - 1) / gamesPerChunk, false)
+        {}
+
+        uint_fast64_t getFirstSeed() const noexcept
+        {
+            return firstSeed;
+        }
+
+        const SamplingBias& getBias() const noexcept
+        {
+            return bias;
+        }
+
+        uint_fast64_t chunks() const noexcept
+        {
+            return completedChunks.size();
+        }
+
+        bool isCompleted(uint_fast64_t chunk) const noexcept
+        {
+            return completedChunks[chunk];
+        }
+
+        // First and one past last game of a chunk, relative to firstSeed
+        std::pair<uint_fast64_t, uint_fast64_t> chunkGames(uint_fast64_t chunk) const noexcept
+        {
+            return {chunk * gamesPerChunk, std::min(games, (chunk + 1) * gamesPerChunk)};
+        }
+
+        void complete(uint_fast64_t chunk, const GameStatistics& chunkStatistics) noexcept
+        {
+            completedChunks[chunk] = true;
+            statistics.merge(chunkStatistics);
+        }
+
+        // Completed chunks are stored as runs of chunk indices: begin end begin end ...
+        void save(std::ostream& out) const
+        {
+            out << checkpointHeader << '\n' << firstSeed << ' ' << games << ' ' << gamesPerChunk << ' ' << policy;
+            bias.save(out);
+            out << '\n';
+            std::vector<uint_fast64_t> runs;
+            for (uint_fast64_t chunk = 0; chunk < chunks(); ++chunk)
+            {
+                if (completedChunks[chunk] && (chunk == 0 || !completedChunks[chunk - 1]))
+                    runs.push_back(chunk);
+                if (completedChunks[chunk] && (chunk + 1 == chunks() || !completedChunks[chunk + 1]))
+                    runs.push_back(chunk + 1);
+            }
+            out << runs.size() / 2;
+            for (uint_fast64_t bound : runs)
+            {
+                out << ' ' << bound;
+            }
+            out << '\n';
+            statistics.save(out);
+        }
+
+        // Fails if the stream is not a checkpoint of this run
+        bool load(std::istream& in)
+        {
+            std::string header;
+            std::getline(in, header);
+            uint_fast64_t savedFirstSeed = 0;
+            uint_fast64_t savedGames = 0;
+            uint_fast64_t savedChunkSize = 0;
+            std::string savedPolicy;
+            SamplingBias savedBias;
+            uint_fast64_t runCount = 0;
+            in >> savedFirstSeed >> savedGames >> savedChunkSize >> savedPolicy;
+            savedBias.load(in);
+            in >> runCount;
+            if (!in || header != checkpointHeader || savedFirstSeed != firstSeed || savedGames != games || savedChunkSize != gamesPerChunk
+                || savedPolicy != policy || !(savedBias == bias))
+                return false;
+            std::fill(completedChunks.begin(), completedChunks.end(), false);
+            for (uint_fast64_t run = 0; run < runCount; ++run)
+            {
+                uint_fast64_t begin = 0;
+                uint_fast64_t end = 0;
+                in >> begin >> end;
+                if (!in || begin > end || end > chunks())
+                    return false;
+                std::fill(completedChunks.begin() + begin, completedChunks.begin() + end, true);
+            }
+            statistics = GameStatistics{};
+            return statistics.load(in);
+        }
+
+        // Writes to a temporary file first so an interrupted save keeps the previous checkpoint
+        bool save(const std::filesystem::path& path) const
+        {
+            std::filesystem::path temporary{path};
+            temporary += ".tmp";
+            {
+                std::ofstream out{temporary, std::ios::trunc};
+                save(out);
+                if (!out.flush())
+                    return false;
+            }
+            std::error_code error;
+            std::filesystem::rename(temporary, path, error);
+            return !error;
+        }
+
+        bool load(const std::filesystem::path& path)
+        {
+            std::ifstream in{path};
+            return in && load(in);
+        }
+};
+
+// Runs work on the given number of threads, at least one, and waits for all
+// of them. If a thread cannot be started, the ones already running are joined
+// before the error propagates, and their work is still done.
+template <class Work>
+void runOnThreads(uint_fast64_t threads, const Work& work)
+{
+    threads = std::max<uint_fast64_t>(1, threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    try
+    {
+        for (uint_fast64_t thread = 0; thread < threads; ++thread)
+        {
+            workers.emplace_back(work);
+        }
+    }
+    catch (...)
+    {
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        throw;
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Plays every chunk the checkpoint has not completed yet, handing out chunks
+// to the worker threads as they finish the previous one. With a checkpoint
+// path the progress is saved whenever checkpointInterval seconds have passed
+// since the last save, and once more at the end. Games are set up with the
+// bias of the checkpoint, from the setup cache if one made for that bias is
+// given.
+template <int_fast64_t roles, class Policy = PassivePolicy>
+void runGames(Checkpoint& progress, uint_fast64_t threads, const std::filesystem::path& checkpointPath = {}, double checkpointInterval = 60.0
+              , SetupCache* cache = nullptr)
+{
+    const SamplingBias& bias = progress.getBias();
+    if (cache && cache->getEpidemicTilts() != bias.epidemicTilts)
+        cache = nullptr;
+    std::vector<uint_fast64_t> pendingChunks;
+    for (uint_fast64_t chunk = 0; chunk < progress.chunks(); ++chunk)
+    {
+        if (!progress.isCompleted(chunk))
+            pendingChunks.push_back(chunk);
+    }
+    std::atomic<size_t> nextChunk{0};
+    std::mutex progressMutex;
+    Timer sinceSave;
+    runOnThreads(std::min<uint_fast64_t>(threads, pendingChunks.size()), [&]()
+    {
+        for (size_t pending = nextChunk++; pending < pendingChunks.size(); pending = nextChunk++)
+        {
+            uint_fast64_t chunk = pendingChunks[pending];
+            GameStatistics statistics;
+            auto [begin, end] = progress.chunkGames(chunk);
+            for (uint_fast64_t game = begin; game < end; ++game)
+            {
+                uint_fast64_t seed = progress.getFirstSeed() + game;
+                statistics.add(cache ? Game<roles, Policy>{seed, *cache}.play() : Game<roles, Policy>{seed, Policy{}, bias}.play());
+            }
+            std::lock_guard<std::mutex> lock{progressMutex};
+            progress.complete(chunk, statistics);
+            if (!checkpointPath.empty() && sinceSave.elapsed() >= checkpointInterval)
+            {
+                if (!progress.save(checkpointPath))
+                    std::cerr << "Could not save checkpoint " << checkpointPath << '\n';
+                sinceSave.reset();
+            }
+        }
+    });
+    if (!checkpointPath.empty() && !progress.save(checkpointPath))
+        std::cerr << "Could not save checkpoint " << checkpointPath << '\n';
+}
+
+// Statistics of the games seeded firstSeed .. firstSeed + games - 1, as written
+// by one shard of the run of a policy and sampling bias over totalFirstSeed ..
+// totalFirstSeed + totalGames - 1
+struct ShardResult
+{
+    uint_fast64_t firstSeed{0};
+    uint_fast64_t games{0};
+    GameStatistics statistics;
+    uint_fast64_t totalFirstSeed{0};
+    uint_fast64_t totalGames{0};
+    std::string policy{PassivePolicy::name};
+    SamplingBias bias;
+
+    void save(std::ostream& out) const
+    {
+        out << resultHeader << '\n' << firstSeed << ' ' << games << ' ' << totalFirstSeed << ' ' << totalGames << ' ' << policy;
+        bias.save(out);
+        out << '\n';
+        statistics.save(out);
+    }
+
+    bool load(std::istream& in)
+    {
+        std::string header;
+        std::getline(in, header);
+        in >> firstSeed >> games >> totalFirstSeed >> totalGames >> policy;
+        bias.load(in);
+        return in && header == resultHeader && firstSeed >= totalFirstSeed && firstSeed - totalFirstSeed + games <= totalGames
+            && statistics.load(in) && statistics.games() == games;
+    }
+};
+
+// Seeds of shard index out of shards: disjoint, contiguous ranges that cover every game
+inline std::pair<uint_fast64_t, uint_fast64_t> shardRange(uint_fast64_t firstSeed, uint_fast64_t games, uint_fast64_t index, uint_fast64_t shards) noexcept
+{
+    uint_fast64_t shardSize = games / shards;
+    uint_fast64_t remainder = games % shards;
+    uint_fast64_t begin = index * shardSize + std::min(index, remainder);
+    return {firstSeed + begin, shardSize + (index < remainder ? 1 : 0)};
+}
+
+// Combines shard results into the result of the single run they were split
+// from. Fails unless the shards belong to one run, with one policy and bias,
+// and cover each of its seeds exactly once.
+inline std::optional<ShardResult> mergeResults(std::vector<ShardResult> shards)
+{
+    if (shards.empty())
+        return std::nullopt;
+    std::sort(shards.begin(), shards.end(), [](const ShardResult& lhs, const ShardResult& rhs){ return lhs.firstSeed < rhs.firstSeed; });
+    const ShardResult& first = shards.front();
+    ShardResult result{first.totalFirstSeed, 0, GameStatistics{}, first.totalFirstSeed, first.totalGames, first.policy, first.bias};
+    for (const ShardResult& shard : shards)
+    {
+        if (shard.totalFirstSeed != result.totalFirstSeed || shard.totalGames != result.totalGames || shard.policy != result.policy
+            || !(shard.bias == result.bias) || shard.firstSeed != result.firstSeed + result.games)
+            return std::nullopt;
+        result.games += shard.games;
+        result.statistics.merge(shard.statistics);
+    }
+    if (result.games != result.totalGames)
+        return std::nullopt;
+    return result;
+}
+
+template <int_fast64_t roles, class Policy = PassivePolicy>
+GameStatistics runGames(uint_fast64_t firstSeed, uint_fast64_t games, uint_fast64_t threads, const SamplingBias& bias = SamplingBias{})
+{
+    Checkpoint progress{firstSeed, games, Policy::name, bias};
+    runGames<roles, Policy>(progress, threads);
+    return progress.statistics;
+}
+#endif
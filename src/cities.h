@@ -1,16 +1,73 @@
 #include "gameConstants.h"
 #include <sstream>
+#include <algorithm>
 #include <array>
 #include <unordered_set>
 
 #ifndef CITIES
 #define CITIES
 
-std::ostream& operator << (std::ostream& lhs, Cities rhs)
+inline std::ostream& operator << (std::ostream& lhs, Cities rhs)
 {
     return lhs << static_cast<int_fast16_t>(rhs);
 }
 
+inline const std::array<std::unordered_set<Cities>, numCities> cityConnections
+{
+	// blue cities
+	std::unordered_set<Cities>{Cities::chicago, Cities::washington, Cities::miami},
+	std::unordered_set<Cities>{Cities::atlanta, Cities::montreal, Cities::sanFrancisco, Cities::losAngeles, Cities::mexicoCity},
+	std::unordered_set<Cities>{Cities::london, Cities::milan, Cities::paris, Cities::stPetersburg},
+	std::unordered_set<Cities>{Cities::essen, Cities::madrid, Cities::newYork, Cities::paris},
+	std::unordered_set<Cities>{Cities::london, Cities::newYork, Cities::paris, Cities::saoPaulo, Cities::algiers},
+	std::unordered_set<Cities>{Cities::essen, Cities::paris, Cities::istanbul},
+	std::unordered_set<Cities>{Cities::chicago, Cities::newYork, Cities::washington},
+	std::unordered_set<Cities>{Cities::london, Cities::madrid, Cities::montreal, Cities::washington},
+	std::unordered_set<Cities>{Cities::essen, Cities::london, Cities::madrid, Cities::milan, Cities::algiers},
+	std::unordered_set<Cities>{Cities::chicago, Cities::manila, Cities::tokyo, Cities::losAngeles},
+	std::unordered_set<Cities>{Cities::essen, Cities::istanbul, Cities::moscow},
+	std::unordered_set<Cities>{Cities::atlanta, Cities::montreal, Cities::newYork, Cities::miami},
+	// yellow cities
+	std::unordered_set<Cities>{Cities::buenosAires, Cities::lima, Cities::mexicoCity, Cities::miami, Cities::saoPaulo},
+	std::unordered_set<Cities>{Cities::bogota, Cities::saoPaulo},
+	std::unordered_set<Cities>{Cities::khartoum, Cities::kinshasa},
+	std::unordered_set<Cities>{Cities::johannesburg, Cities::kinshasa, Cities::lagos, Cities::cairo},
+	std::unordered_set<Cities>{Cities::johannesburg, Cities::khartoum, Cities::lagos},
+	std::unordered_set<Cities>{Cities::khartoum, Cities::kinshasa, Cities::saoPaulo},
+	std::unordered_set<Cities>{Cities::bogota, Cities::mexicoCity, Cities::santiago},
+	std::unordered_set<Cities>{Cities::chicago, Cities::sanFrancisco, Cities::mexicoCity, Cities::sydney},
+	std::unordered_set<Cities>{Cities::chicago, Cities::bogota, Cities::lima, Cities::losAngeles, Cities::miami},
+	std::unordered_set<Cities>{Cities::atlanta, Cities::washington, Cities::bogota, Cities::mexicoCity},
+	std::unordered_set<Cities>{Cities::lima},
+	std::unordered_set<Cities>{Cities::madrid, Cities::bogota, Cities::buenosAires, Cities::lagos},
+	// black cities
+	std::unordered_set<Cities>{Cities::madrid, Cities::paris, Cities::cairo, Cities::istanbul},
+	std::unordered_set<Cities>{Cities::cairo, Cities::istanbul, Cities::karachi, Cities::riyadh, Cities::tehran},
+	std::unordered_set<Cities>{Cities::khartoum, Cities::algiers, Cities::baghdad, Cities::istanbul, Cities::riyadh},
+	std::unordered_set<Cities>{Cities::delhi, Cities::kolkata, Cities::mumbai, Cities::bangkok, Cities::jakarta},
+	std::unordered_set<Cities>{Cities::chennai, Cities::karachi, Cities::kolkata, Cities::mumbai, Cities::tehran},
+	std::unordered_set<Cities>{Cities::milan, Cities::stPetersburg, Cities::algiers, Cities::baghdad, Cities::cairo, Cities::moscow},
+	std::unordered_set<Cities>{Cities::baghdad, Cities::delhi, Cities::mumbai, Cities::riyadh, Cities::tehran},
+	std::unordered_set<Cities>{Cities::chennai, Cities::delhi, Cities::bangkok, Cities::hongKong},
+	std::unordered_set<Cities>{Cities::stPetersburg, Cities::istanbul, Cities::tehran},
+	std::unordered_set<Cities>{Cities::chennai, Cities::delhi, Cities::karachi},
+	std::unordered_set<Cities>{Cities::baghdad, Cities::cairo, Cities::karachi},
+	std::unordered_set<Cities>{Cities::baghdad, Cities::delhi, Cities::karachi, Cities::moscow},
+	// red cities
+	std::unordered_set<Cities>{Cities::chennai, Cities::kolkata, Cities::hoChiMinhCity, Cities::hongKong, Cities::jakarta},
+	std::unordered_set<Cities>{Cities::seoul, Cities::shanghai},
+	std::unordered_set<Cities>{Cities::bangkok, Cities::hongKong, Cities::jakarta, Cities::manila},
+	std::unordered_set<Cities>{Cities::kolkata, Cities::bangkok, Cities::hoChiMinhCity, Cities::manila, Cities::shanghai, Cities::taipei},
+	std::unordered_set<Cities>{Cities::chennai, Cities::bangkok, Cities::hoChiMinhCity, Cities::sydney},
+	std::unordered_set<Cities>{Cities::sanFrancisco, Cities::hoChiMinhCity, Cities::hongKong, Cities::sydney, Cities::taipei},
+	std::unordered_set<Cities>{Cities::taipei, Cities::tokyo},
+	std::unordered_set<Cities>{Cities::beijing, Cities::shanghai, Cities::tokyo},
+	std::unordered_set<Cities>{Cities::beijing, Cities::hongKong, Cities::seoul, Cities::taipei, Cities::tokyo},
+	std::unordered_set<Cities>{Cities::losAngeles, Cities::jakarta, Cities::manila},
+	std::unordered_set<Cities>{Cities::hongKong, Cities::manila, Cities::osaka, Cities::shanghai},
+	std::unordered_set<Cities>{Cities::sanFrancisco, Cities::osaka, Cities::seoul, Cities::shanghai}
+};
+
 class City
 {
     friend std::ostream& operator << (std::ostream& lhs, const City& rhs)
@@ -34,7 +91,7 @@ class City
 
         const Color color;
 
-        constexpr City(std::unordered_set<Cities>&& cities, const Color c = Color::blue)
+        constexpr City(const std::unordered_set<Cities>& cities, const Color c = Color::blue)
             :adjacentCities {cities}, color {c}
         {}
 
@@ -48,6 +105,19 @@ class City
             return adjacentCities.find(city) != adjacentCities.end();
         }
 
+        int_fast16_t getInfectionCount(const Color c) const
+        {
+            return infectionCounts[static_cast<int_fast16_t>(c)];
+        }
+
+        // Returns the number of cubes actually removed
+        int_fast16_t removeInfection(const std::int_fast16_t count, const Color c)
+        {
+            int_fast16_t removed = std::min(count, infectionCounts[static_cast<int_fast16_t>(c)]);
+            infectionCounts[static_cast<int_fast16_t>(c)] -= removed;
+            return removed;
+        }
+
         bool addInfection(const std::int_fast16_t count, const Color c)
         {
             infectionCounts[static_cast<int_fast16_t>(c)] += count;
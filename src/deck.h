@@ -1,5 +1,7 @@
 #include "gameConstants.h"
 #include "cities.h"
+#include <algorithm>
+#include <cmath>
 #include <random>
 #include <numeric>
 #include <iostream>
@@ -8,6 +10,36 @@
 #ifndef DECK
 #define DECK
 
+// Engine of a game. It counts its draws, so a position in the stream of a
+// seed is a single number.
+class CountingEngine : public std::mt19937_64
+{
+    private:
+
+        uint_fast64_t draws{0};
+
+    public:
+
+        using std::mt19937_64::mt19937_64;
+
+        result_type operator()()
+        {
+            ++draws;
+            return std::mt19937_64::operator()();
+        }
+
+        void discard(unsigned long long count)
+        {
+            draws += count;
+            std::mt19937_64::discard(count);
+        }
+
+        uint_fast64_t getDraws() const noexcept
+        {
+            return draws;
+        }
+};
+
 class Card
 {
     friend std::ostream& operator<<(std::ostream& lhs, const Card& rhs)
@@ -130,26 +162,9 @@ class playerDeck: public Deck<playerCard>
     private:
 
         std::array<playerCard, numPlayerCards + gameDifficulty> cards;
-        std::mt19937_64& random;
+        CountingEngine& random;
         int_fast16_t drawIndex{numPlayerCards + gameDifficulty - 1};
 
-        constexpr std::array<int_fast16_t, gameDifficulty> getDeckSizes() const
-        {
-            std::array<int_fast16_t, gameDifficulty> deckSizes;
-            int_fast16_t deckSize = drawIndex + 1;
-            int_fast16_t minSize = 1;
-            int_fast16_t sumOfMins = ((gameDifficulty + minSize) * (gameDifficulty >> 1)) + ((gameDifficulty & 1) * ((gameDifficulty + minSize) >> 1));
-            int_fast16_t multiplesThatFit = (deckSize - sumOfMins) / gameDifficulty;
-            minSize += multiplesThatFit;
-            std::iota(deckSizes.begin(), deckSizes.end(), minSize);
-            int_fast16_t remainder = deckSize - (sumOfMins + (multiplesThatFit * gameDifficulty));
-            while (remainder > 0)
-            {
-                ++deckSizes[--remainder];
-            }
-            return deckSizes;
-        }
-
         std::ostream& write(std::ostream& lhs) const
         {
             std::stringstream result{};
@@ -164,7 +179,7 @@ class playerDeck: public Deck<playerCard>
 
     public:
 
-        constexpr playerDeck(std::mt19937_64& r)
+        constexpr playerDeck(CountingEngine& r)
             : random{r}
         {
             for (int_fast16_t i = 0; i < numCityCards; ++i)
@@ -177,20 +192,72 @@ class playerDeck: public Deck<playerCard>
             }
         }
 
-        void prepareDeck()
+        // Sizes of the piles the epidemic cards are shuffled into, bottom pile first
+        constexpr std::array<int_fast16_t, gameDifficulty> getDeckSizes() const
+        {
+            std::array<int_fast16_t, gameDifficulty> deckSizes;
+            int_fast16_t deckSize = drawIndex + 1;
+            int_fast16_t minSize = 1;
+            int_fast16_t sumOfMins = ((gameDifficulty + minSize) * (gameDifficulty >> 1)) + ((gameDifficulty & 1) * ((gameDifficulty + minSize) >> 1));
+            int_fast16_t multiplesThatFit = (deckSize - sumOfMins) / gameDifficulty;
+            minSize += multiplesThatFit;
+            std::iota(deckSizes.begin(), deckSizes.end(), minSize);
+            int_fast16_t remainder = deckSize - (sumOfMins + (multiplesThatFit * gameDifficulty));
+            while (remainder > 0)
+            {
+                ++deckSizes[--remainder];
+            }
+            return deckSizes;
+        }
+
+        // Places one epidemic card in each pile. With a nonzero tilt the position
+        // of the card, counted from the top of its pile, is drawn with weight
+        // exp(tilt * position / (pile size - 1)) instead of uniformly. Tilts are
+        // ordered from the top pile down. Returns the likelihood ratio of the
+        // uniform placement to the one drawn.
+        double prepareDeck(const std::array<double, gameDifficulty>& tilts = {})
         {
             std::array<int_fast16_t, gameDifficulty> deckSizes = getDeckSizes();
             int_fast16_t index = gameDifficulty - 1;
             auto miniDeckStart = cards.begin() + drawIndex;
             auto epidemicCardIterator = cards.begin();
+            double likelihoodRatio = 1.0;
             while (index >= 0)
             {
                 int_fast16_t deckSize = deckSizes[index];
-                int_fast16_t swapIndex = random() % deckSize;
+                double tilt = std::clamp(tilts[gameDifficulty - 1 - index], -maxEpidemicTilt, maxEpidemicTilt);
+                int_fast16_t swapIndex = 0;
+                if (tilt == 0.0 || deckSize < 2)
+                {
+                    swapIndex = random() % deckSize;
+                }
+                else
+                {
+                    std::array<double, numPlayerCards + gameDifficulty> weights;
+                    double total = 0.0;
+                    for (int_fast16_t position = 0; position < deckSize; ++position)
+                    {
+                        weights[position] = std::exp(tilt * position / (deckSize - 1));
+                        total += weights[position];
+                    }
+                    double target = std::generate_canonical<double, 64>(random) * total;
+                    while (swapIndex < deckSize - 1 && target >= weights[swapIndex])
+                    {
+                        target -= weights[swapIndex];
+                        ++swapIndex;
+                    }
+                    likelihoodRatio *= total / (deckSize * weights[swapIndex]);
+                }
                 std::swap(*(epidemicCardIterator + index), *(miniDeckStart - swapIndex));
                 miniDeckStart -= deckSize;
                 --index;
             }
+            return likelihoodRatio;
+        }
+
+        int_fast16_t cardsLeft() const
+        {
+            return drawIndex + 1;
         }
 
         const playerCard& drawCard()
@@ -204,6 +271,23 @@ class playerDeck: public Deck<playerCard>
         {
             std::shuffle(cards.begin() + gameDifficulty, cards.end(), random);
         }
+
+        // Puts back a stored order of the full deck, as left by prepareDeck
+        void restore(const std::array<int8_t, numPlayerCards + gameDifficulty>& numbers)
+        {
+            std::copy(numbers.begin(), numbers.end(), cards.begin());
+            drawIndex = numPlayerCards + gameDifficulty - 1;
+        }
+
+        const std::array<playerCard, numPlayerCards + gameDifficulty>& getCards() const
+        {
+            return cards;
+        }
+
+        int_fast16_t getDrawIndex() const
+        {
+            return drawIndex;
+        }
 };
 
 class infectionDeck : public Deck<infectionCard>
@@ -211,7 +295,7 @@ class infectionDeck : public Deck<infectionCard>
     private:
 
         std::array<infectionCard, numCityCards + gameDifficulty> cards;
-        std::mt19937_64& random;
+        CountingEngine& random;
         int_fast16_t drawIndex{numCityCards - 1};
         int_fast16_t epidemicIndex{0};
         int_fast16_t backOfDeck{numCityCards};
@@ -235,7 +319,7 @@ class infectionDeck : public Deck<infectionCard>
 
     public:
 
-        constexpr infectionDeck(std::mt19937_64& r)
+        constexpr infectionDeck(CountingEngine& r)
             : random{r}
         {
             for (int_fast16_t i = 0; i < numCityCards; ++i)
@@ -255,19 +339,33 @@ class infectionDeck : public Deck<infectionCard>
             return cards[epidemicIndex++].getNumber<Cities>();
         }
 
+        // Takes a city's card out of the game, returns false if it is not in the discard pile
+        bool removeFromDiscard(Cities cityToRemove)
+        {
+            auto removedCity = std::find_if(cards.begin() + drawIndex + 1, cards.begin() + backOfDeck
+                                                , [&](const infectionCard& c){ return c.getNumber<Cities>() == cityToRemove; });
+            if (removedCity == cards.begin() + backOfDeck)
+                return false;
+            --backOfDeck;
+            std::swap(*removedCity, *(cards.begin() + backOfDeck));
+            return true;
+        }
+
         void intensify(Cities cityToRemove, bool removeCity)
         {
             if (removeCity)
             {
-                auto removedCity = std::find_if(cards.begin() + drawIndex + 1, cards.begin() + backOfDeck
-                                                    , [&](const infectionCard& c){ return c.getNumber<Cities>() == cityToRemove; });
-                --backOfDeck;
-                std::swap(*removedCity, *(cards.begin() + backOfDeck));
+                removeFromDiscard(cityToRemove);
             }
             std::shuffle(cards.begin() + drawIndex + 1, cards.begin() + backOfDeck, random);
             drawIndex = backOfDeck - 1;
         }
 
+        int_fast16_t cardsLeft() const
+        {
+            return drawIndex - epidemicIndex + 1;
+        }
+
         const infectionCard& drawCard()
         {
             const infectionCard& result = *(cards.begin() + drawIndex);
@@ -279,5 +377,26 @@ class infectionDeck : public Deck<infectionCard>
         {
             std::shuffle(cards.begin(), cards.begin() + numCityCards, random);
         }
+
+        // Puts back a stored order of the city cards, as left by beginningShuffle
+        void restore(const std::array<int8_t, numCityCards>& numbers)
+        {
+            std::copy(numbers.begin(), numbers.end(), cards.begin());
+        }
+
+        const std::array<infectionCard, numCityCards + gameDifficulty>& getCards() const
+        {
+            return cards;
+        }
+
+        int_fast16_t getDrawIndex() const
+        {
+            return drawIndex;
+        }
+
+        int_fast16_t getBackOfDeck() const
+        {
+            return backOfDeck;
+        }
 };
 #endif
\ No newline at end of file
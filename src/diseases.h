@@ -1,5 +1,8 @@
 #include "gameConstants.h"
 
+#ifndef DISEASES
+#define DISEASES
+
 class Disease
 {
     private:
@@ -24,12 +27,17 @@ class Disease
             return cubesLeft >= 0;
         }
 
-        bool isCured()
+        int_fast16_t getCubesLeft() const
+        {
+            return cubesLeft;
+        }
+
+        bool isCured() const
         {
             return status == cured;
         }
 
-        bool isEradicated()
+        bool isEradicated() const
         {
             return status == eradicated;
         }
@@ -38,4 +46,5 @@ class Disease
         {
             this->status = status; 
         }
-};
\ No newline at end of file
+};
+#endif
\ No newline at end of file
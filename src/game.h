@@ -2,8 +2,16 @@
 #include "diseases.h"
 #include "deck.h"
 #include "players.h"
+#include "policies.h"
+#include "setupCache.h"
+#include <bitset>
+#include <limits>
 #include <string>
 #include <sstream>
+#include <utility>
+
+#ifndef GAME
+#define GAME
 
 class Timer
 {
@@ -30,93 +38,62 @@ public:
 	}
 };
 
-template <int_fast64_t roles>
+struct GameResult
+{
+    Outcome outcome{Outcome::ongoing};
+    int_fast16_t turns{0};
+    int_fast16_t outbreaks{0};
+    int_fast16_t epidemics{0};
+    double likelihoodRatio{1.0};
+};
+
+// Biases the setup toward rare scenarios. Every game records the likelihood
+// ratio of the unbiased setup to the biased one, weighting results by it
+// keeps estimates unbiased.
+struct SamplingBias
+{
+    // Per pile from the top, see playerDeck::prepareDeck
+    std::array<double, gameDifficulty> epidemicTilts{};
+
+    // Tilts are written with enough digits to read back exactly
+    void save(std::ostream& out) const
+    {
+        std::streamsize precision = out.precision(std::numeric_limits<double>::max_digits10);
+        for (double tilt : epidemicTilts)
+        {
+            out << ' ' << tilt;
+        }
+        out.precision(precision);
+    }
+
+    bool load(std::istream& in)
+    {
+        for (double& tilt : epidemicTilts)
+        {
+            in >> tilt;
+        }
+        return static_cast<bool>(in);
+    }
+
+    bool operator==(const SamplingBias& rhs) const = default;
+};
+
+template <int_fast64_t roles, class Policy = PassivePolicy>
 class Game
 {
     private:
 
-        std::mt19937_64 random;
-        const std::array<City, numCities> cities
-        {
-            City(std::unordered_set<Cities>{Cities::chicago, Cities::washington, Cities::miami}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::atlanta, Cities::montreal, Cities::sanFrancisco, Cities::losAngeles, Cities::mexicoCity}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::london, Cities::milan, Cities::paris, Cities::stPetersburg}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::essen, Cities::madrid, Cities::newYork, Cities::paris}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::london, Cities::newYork, Cities::paris, Cities::saoPaulo, Cities::algiers}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::essen, Cities::paris, Cities::istanbul}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::chicago, Cities::newYork, Cities::washington}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::london, Cities::madrid, Cities::montreal, Cities::washington}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::essen, Cities::london, Cities::madrid, Cities::milan, Cities::algiers}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::chicago, Cities::manila, Cities::tokyo, Cities::losAngeles}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::essen, Cities::istanbul, Cities::moscow}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::atlanta, Cities::montreal, Cities::newYork, Cities::miami}, Color::blue),
-	        City(std::unordered_set<Cities>{Cities::buenosAires, Cities::lima, Cities::mexicoCity, Cities::miami, Cities::saoPaulo}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::bogota, Cities::saoPaulo}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::khartoum, Cities::kinshasa}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::johannesburg, Cities::kinshasa, Cities::lagos, Cities::cairo}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::johannesburg, Cities::khartoum, Cities::lagos}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::khartoum, Cities::kinshasa, Cities::saoPaulo}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::bogota, Cities::mexicoCity, Cities::santiago}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::sanFrancisco, Cities::mexicoCity, Cities::sydney}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::chicago, Cities::bogota, Cities::lima, Cities::losAngeles, Cities::miami}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::atlanta, Cities::washington, Cities::bogota, Cities::mexicoCity}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::lima}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::madrid, Cities::bogota, Cities::buenosAires, Cities::lagos}, Color::yellow),
-	        City(std::unordered_set<Cities>{Cities::madrid, Cities::paris, Cities::cairo, Cities::istanbul}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::cairo, Cities::istanbul, Cities::karachi, Cities::moscow, Cities::riyadh, Cities::tehran}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::khartoum, Cities::algiers, Cities::baghdad, Cities::istanbul, Cities::riyadh}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::delhi, Cities::kolkata, Cities::mumbai, Cities::bangkok, Cities::jakarta}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::chennai, Cities::karachi, Cities::kolkata, Cities::mumbai, Cities::tehran}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::milan, Cities::stPetersburg, Cities::algiers, Cities::baghdad, Cities::cairo, Cities::moscow}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::baghdad, Cities::delhi, Cities::mumbai, Cities::riyadh, Cities::tehran}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::chennai, Cities::delhi, Cities::bangkok, Cities::hongKong}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::stPetersburg, Cities::istanbul, Cities::tehran}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::chennai, Cities::delhi, Cities::karachi}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::baghdad, Cities::cairo, Cities::karachi}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::baghdad, Cities::delhi, Cities::karachi, Cities::moscow}, Color::black),
-	        City(std::unordered_set<Cities>{Cities::chennai, Cities::kolkata, Cities::hoChiMinhCity, Cities::hongKong, Cities::jakarta}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::seoul, Cities::shanghai}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::bangkok, Cities::hoChiMinhCity, Cities::hongKong, Cities::manila}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::kolkata, Cities::bangkok, Cities::hoChiMinhCity, Cities::manila, Cities::shanghai, Cities::taipei}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::chennai, Cities::bangkok, Cities::hoChiMinhCity, Cities::sydney}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::sanFrancisco, Cities::hoChiMinhCity, Cities::hongKong, Cities::sydney, Cities::taipei}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::taipei, Cities::tokyo}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::beijing, Cities::shanghai, Cities::tokyo}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::beijing, Cities::hongKong, Cities::seoul, Cities::taipei, Cities::tokyo}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::losAngeles, Cities::jakarta, Cities::manila}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::hongKong, Cities::manila, Cities::osaka, Cities::shanghai}, Color::red),
-	        City(std::unordered_set<Cities>{Cities::sanFrancisco, Cities::osaka, Cities::seoul, Cities::shanghai}, Color::red)
-        };
-        //std::array<Player, numPlayers> players;
+        CountingEngine random;
+        std::array<City, numCities> cities{createCities(std::make_index_sequence<numCities>{})};
+        std::array<Player, numPlayers> players{createPlayers(std::make_index_sequence<numPlayers>{})};
         std::array<int_fast16_t, maxOutbreaks + gameDifficulty + 1> infectionRates;
         std::unordered_set<Cities> researchStations { Cities::atlanta };
         std::array<Disease, numDiseases> diseases{Color::blue, Color::yellow, Color::black, Color::red};
         playerDeck pDeck;
         infectionDeck iDeck;
-
-        /*
-        constexpr std::array<Player, numPlayers> initializeRoles()
-        {
-            std::array<Player, numPlayers> result;
-            int_fast64_t roleBytes = roles;
-            int_fast16_t players = numPlayers;
-            int_fast16_t bitsInByte = 8;
-            constexpr int_fast8_t roleMask = 255;
-            while (players)
-            {
-                result[players] = Player{static_cast<Roles>(roleMask & roleBytes)};
-                roleBytes = roleBytes >> bitsInByte;
-            }
-            return result;
-        }
-
-        std::array<Player, numPlayers> initializePlayers()
-        {
-            std::array<Player, numPlayers> result = initializeRoles();
-            std::shuffle(result.begin(), result.end(), random);
-            return result;
-        }
-        */
+        GameResult result;
+        Policy policy;
+        bool quietNight{false};
 
         constexpr void initializeInfectionRates() noexcept
         {
@@ -139,12 +116,17 @@ class Game
             std::fill(beginRange, end, currentRate);
         }
 
-        template <class C>
-        C createDeck() noexcept
+        template <size_t... cityIndices>
+        static std::array<City, numCities> createCities(std::index_sequence<cityIndices...>)
         {
-            C result{random};
-            result.beginningShuffle();
-            return result;
+            return {City(cityConnections[cityIndices], static_cast<Color>(cityIndices / citiesPerColor))...};
+        }
+
+        // Player i takes the role in byte i of roles
+        template <size_t... playerIndices>
+        static std::array<Player, numPlayers> createPlayers(std::index_sequence<playerIndices...>)
+        {
+            return {Player{static_cast<Roles>((roles >> (bitsInByte * playerIndices)) & roleMask)}...};
         }
 
         constexpr int cardsPerPlayer() const noexcept
@@ -163,7 +145,7 @@ class Game
             {
                 for (int_fast16_t cardsDealt = 0; cardsDealt < cardsPerPlayer(); cardsDealt++)
                 {
-                    pDeck.drawCard();
+                    players[player].addCard(pDeck.drawCard());
                 }
             }
         }
@@ -175,20 +157,397 @@ class Game
                 for (int_fast16_t city = 0; city < citiesPerWave; ++city)
                 {
                     const infectionCard& iCard = iDeck.drawCard();
-                    City target = cities[iCard.getNumber<int_fast16_t>()];
-                    target.addInfection(strongestWave - wave, target.color);
+                    infect(iCard.getNumber<Cities>(), strongestWave - wave);
                 }
             }
         }
 
-    public:
+        void setUp(const SamplingBias& bias) noexcept
+        {
+            pDeck.beginningShuffle();
+            iDeck.beginningShuffle();
+            dealPlayerCards();
+            result.likelihoodRatio = pDeck.prepareDeck(bias.epidemicTilts);
+            initialInfections();
+        }
 
-        Game(uint_fast64_t seed) noexcept
-            : random{seed}, pDeck{createDeck<playerDeck>()}, iDeck{createDeck<infectionDeck>()}
+        // Dealing and the initial infections only draw from the restored decks
+        void restore(const SetupRecord& record) noexcept
         {
-            initializeInfectionRates();
+            pDeck.restore(record.playerCards);
+            iDeck.restore(record.infectionCards);
+            random.discard(record.draws);
             dealPlayerCards();
-            pDeck.prepareDeck();
+            result.likelihoodRatio = record.likelihoodRatio;
             initialInfections();
         }
-};
\ No newline at end of file
+
+        // Only meaningful before the first turn
+        SetupRecord recordSetup() const noexcept
+        {
+            SetupRecord record{};
+            record.draws = random.getDraws();
+            record.likelihoodRatio = result.likelihoodRatio;
+            std::transform(pDeck.getCards().begin(), pDeck.getCards().end(), record.playerCards.begin()
+                            , [](const playerCard& card){ return card.getNumber<int8_t>(); });
+            std::transform(iDeck.getCards().begin(), iDeck.getCards().begin() + numCityCards, record.infectionCards.begin()
+                            , [](const infectionCard& card){ return card.getNumber<int8_t>(); });
+            return record;
+        }
+
+        void infect(Cities city, Color color, int_fast16_t cubes, std::bitset<numCities>& outbreakCities) noexcept
+        {
+            Disease& disease = diseases[static_cast<int_fast16_t>(color)];
+            if (disease.isEradicated() || result.outcome != Outcome::ongoing)
+                return;
+            City& target = cities[static_cast<int_fast16_t>(city)];
+            int_fast16_t before = target.getInfectionCount(color);
+            bool outbreak = target.addInfection(cubes, color);
+            if (!disease.adjustCubes(before - target.getInfectionCount(color)))
+            {
+                result.outcome = Outcome::cubeLoss;
+                return;
+            }
+            if (outbreak && !outbreakCities.test(static_cast<int_fast16_t>(city)))
+            {
+                outbreakCities.set(static_cast<int_fast16_t>(city));
+                if (++result.outbreaks > maxOutbreaks)
+                {
+                    result.outcome = Outcome::outbreakLoss;
+                    return;
+                }
+                for (Cities neighbor : target.getAdjacentCities())
+                {
+                    infect(neighbor, color, 1, outbreakCities);
+                }
+            }
+        }
+
+        void infect(Cities city, int_fast16_t cubes) noexcept
+        {
+            std::bitset<numCities> outbreakCities;
+            infect(city, cities[static_cast<int_fast16_t>(city)].color, cubes, outbreakCities);
+        }
+
+        void epidemic() noexcept
+        {
+            ++result.epidemics;
+            Cities city = iDeck.infect();
+            infect(city, epidemicInfection);
+            iDeck.intensify(city, false);
+        }
+
+        void discardColor(Player& player, Color color, int_fast16_t count) noexcept
+        {
+            for (int_fast16_t card = static_cast<int_fast16_t>(color) * citiesPerColor; count > 0; ++card)
+            {
+                if (player.getCards().test(card))
+                {
+                    player.removeCard(playerCard{card});
+                    --count;
+                }
+            }
+        }
+
+        void applyAction(const Action& action, int_fast16_t player) noexcept
+        {
+            Player& p = players[player];
+            Disease& disease = diseases[static_cast<int_fast16_t>(action.color)];
+            switch (action.type)
+            {
+                case ActionType::pass:
+                    break;
+                case ActionType::directFlight:
+                    p.removeCard(playerCard{static_cast<int_fast16_t>(action.city)});
+                    [[fallthrough]];
+                case ActionType::drive:
+                    p.setLocation(action.city);
+                    break;
+                case ActionType::treat:
+                {
+                    int_fast16_t cubes = disease.isCured() || p.getRole() == Roles::medic ? maxInfection : 1;
+                    disease.adjustCubes(cities[static_cast<int_fast16_t>(p.getLocation())].removeInfection(cubes, action.color));
+                    break;
+                }
+                case ActionType::buildResearchStation:
+                    p.removeCard(playerCard{static_cast<int_fast16_t>(p.getLocation())});
+                    researchStations.insert(p.getLocation());
+                    break;
+                case ActionType::discoverCure:
+                    discardColor(p, action.color, cardsToCure(player));
+                    disease.changeStatus(cured);
+                    disease.adjustCubes(0);
+                    if (std::all_of(diseases.begin(), diseases.end(), [](const Disease& d){ return d.isCured() || d.isEradicated(); }))
+                        result.outcome = Outcome::won;
+                    break;
+            }
+        }
+
+        void infectCities() noexcept
+        {
+            for (int_fast16_t card = 0; card < infectionRate() && result.outcome == Outcome::ongoing; ++card)
+            {
+                // An exhausted infection deck is refilled from its discard pile
+                if (iDeck.cardsLeft() == 0)
+                    iDeck.intensify(Cities::atlanta, false);
+                infect(iDeck.drawCard().getNumber<Cities>(), 1);
+            }
+        }
+
+    public:
+
+        Game(uint_fast64_t seed, Policy p = Policy{}, const SamplingBias& bias = SamplingBias{}) noexcept
+            : random{seed}, pDeck{random}, iDeck{random}, policy{p}
+        {
+            initializeInfectionRates();
+            setUp(bias);
+        }
+
+        // Restores the setup of a seed the cache holds, and sets up and stores
+        // one it does not. Either way the game is the one Game{seed} plays with
+        // the cache's bias.
+        Game(uint_fast64_t seed, SetupCache& cache, Policy p = Policy{}) noexcept
+            : random{seed}, pDeck{random}, iDeck{random}, policy{p}
+        {
+            initializeInfectionRates();
+            if (const SetupRecord* record = cache.lookup(seed))
+            {
+                restore(*record);
+                return;
+            }
+            setUp(SamplingBias{cache.getEpidemicTilts()});
+            cache.store(seed, recordSetup());
+        }
+
+        // Plays turns until the game is decided. Illegal decisions of the policy
+        // are skipped: an illegal action is lost, an illegal event is not played.
+        GameResult play() noexcept
+        {
+            static_assert(AgentPolicy<Policy, Game>);
+            while (!isOver())
+            {
+                int_fast16_t player = beginTurn();
+                for (int_fast16_t action = 0; action < actionsPerTurn && !isOver(); ++action)
+                {
+                    takeAction(policy.chooseAction(*this, player), player);
+                }
+                for (int_fast16_t card = 0; card < cardsDrawnPerTurn && !isOver(); ++card)
+                {
+                    drawPlayerCard(player);
+                    while (overHandLimit(player))
+                    {
+                        discard(player, policy.chooseDiscard(*this, player));
+                    }
+                }
+                while (!isOver())
+                {
+                    std::optional<EventPlay> event = policy.chooseEvent(*this);
+                    if (!event || !playEvent(*event))
+                        break;
+                }
+                endTurn();
+            }
+            return result;
+        }
+
+        // The steps of a turn, for callers that make the decisions themselves.
+        // A turn is beginTurn, up to actionsPerTurn actions, cardsDrawnPerTurn
+        // draws each followed by discards down to the hand limit, any events,
+        // and endTurn. Events may also be played between actions.
+
+        // Returns the player whose turn begins
+        int_fast16_t beginTurn() noexcept
+        {
+            return result.turns++ % numPlayers;
+        }
+
+        // Returns false and changes nothing if the action is illegal
+        bool takeAction(const Action& action, int_fast16_t player) noexcept
+        {
+            if (!isLegal(action, player))
+                return false;
+            applyAction(action, player);
+            return true;
+        }
+
+        void drawPlayerCard(int_fast16_t player) noexcept
+        {
+            if (pDeck.cardsLeft() == 0)
+            {
+                result.outcome = Outcome::playerDeckLoss;
+                return;
+            }
+            const playerCard& drawn = pDeck.drawCard();
+            if (drawn.getNumber<int_fast16_t>() == epidemicCard)
+                epidemic();
+            else
+                players[player].addCard(drawn);
+        }
+
+        bool overHandLimit(int_fast16_t player) const noexcept
+        {
+            return static_cast<int_fast16_t>(players[player].getCards().count()) > maxCards;
+        }
+
+        // Discards the player's lowest card instead of a card they do not hold
+        void discard(int_fast16_t player, playerCard card) noexcept
+        {
+            int_fast16_t number = card.getNumber<int_fast16_t>();
+            if (number < 0 || number >= numPlayerCards || !players[player].getCards().test(number))
+                card = playerCard{players[player].firstCard()};
+            players[player].removeCard(card);
+        }
+
+        // Returns false and changes nothing if the event cannot be played
+        bool playEvent(const EventPlay& play) noexcept
+        {
+            if (!isLegal(play))
+                return false;
+            Player& p = players[play.player];
+            p.removeCard(playerCard{static_cast<int_fast16_t>(play.event)});
+            switch (play.event)
+            {
+                case Events::airlift:
+                    p.setLocation(play.target);
+                    break;
+                case Events::governmentGrant:
+                    researchStations.insert(play.target);
+                    break;
+                case Events::oneQuietNight:
+                    quietNight = true;
+                    break;
+                case Events::ResilientPopulation:
+                    iDeck.removeFromDiscard(play.target);
+                    break;
+                case Events::forecast:
+                    break;
+            }
+            return true;
+        }
+
+        void endTurn() noexcept
+        {
+            if (quietNight)
+                quietNight = false;
+            else
+                infectCities();
+        }
+
+        bool isOver() const noexcept
+        {
+            return result.outcome != Outcome::ongoing;
+        }
+
+        // Actions naming a city or color that does not exist are illegal
+        bool isLegal(const Action& action, int_fast16_t player) const noexcept
+        {
+            if (player < 0 || player >= numPlayers || static_cast<uint_fast16_t>(action.city) >= numCities
+                || static_cast<uint_fast16_t>(action.color) >= numDiseases)
+                return false;
+            const Player& p = players[player];
+            Cities here = p.getLocation();
+            switch (action.type)
+            {
+                case ActionType::pass:
+                    return true;
+                case ActionType::drive:
+                    return cities[static_cast<int_fast16_t>(here)].isAdjacent(action.city);
+                case ActionType::directFlight:
+                    return action.city != here && p.getCards().test(static_cast<int_fast16_t>(action.city));
+                case ActionType::treat:
+                    return cities[static_cast<int_fast16_t>(here)].getInfectionCount(action.color) > 0;
+                case ActionType::buildResearchStation:
+                    return p.getCards().test(static_cast<int_fast16_t>(here)) && !researchStations.count(here)
+                        && static_cast<int_fast16_t>(researchStations.size()) < numResearchStations;
+                case ActionType::discoverCure:
+                {
+                    int_fast16_t held = 0;
+                    for (int_fast16_t card = static_cast<int_fast16_t>(action.color) * citiesPerColor, end = card + citiesPerColor; card < end; ++card)
+                    {
+                        held += p.getCards().test(card);
+                    }
+                    return researchStations.count(here) && !isCured(action.color) && held >= cardsToCure(player);
+                }
+            }
+            return false;
+        }
+
+        // Forecast is not supported and never legal
+        bool isLegal(const EventPlay& play) const noexcept
+        {
+            if (play.player < 0 || play.player >= numPlayers || static_cast<uint_fast16_t>(play.target) >= numCities
+                || static_cast<int_fast16_t>(play.event) < static_cast<int_fast16_t>(Events::airlift)
+                || static_cast<int_fast16_t>(play.event) > static_cast<int_fast16_t>(Events::ResilientPopulation)
+                || !players[play.player].getCards().test(static_cast<int_fast16_t>(play.event)))
+                return false;
+            switch (play.event)
+            {
+                case Events::airlift:
+                case Events::oneQuietNight:
+                    return true;
+                case Events::governmentGrant:
+                    return !researchStations.count(play.target) && static_cast<int_fast16_t>(researchStations.size()) < numResearchStations;
+                case Events::ResilientPopulation:
+                {
+                    const auto& discard = iDeck.getCards();
+                    return std::any_of(discard.begin() + iDeck.getDrawIndex() + 1, discard.begin() + iDeck.getBackOfDeck()
+                                        , [&](const infectionCard& c){ return c.getNumber<Cities>() == play.target; });
+                }
+                case Events::forecast:
+                    return false;
+            }
+            return false;
+        }
+
+        bool isCured(Color color) const noexcept
+        {
+            const Disease& disease = diseases[static_cast<int_fast16_t>(color)];
+            return disease.isCured() || disease.isEradicated();
+        }
+
+        int_fast16_t cardsToCure(int_fast16_t player) const noexcept
+        {
+            return players[player].getRole() == Roles::scientist ? scientistCardsToCure : ::cardsToCure;
+        }
+
+        int_fast16_t infectionRate() const noexcept
+        {
+            return infectionRates[result.epidemics];
+        }
+
+        const GameResult& getResult() const noexcept
+        {
+            return result;
+        }
+
+        const std::array<Player, numPlayers>& getPlayers() const noexcept
+        {
+            return players;
+        }
+
+        const std::unordered_set<Cities>& getResearchStations() const noexcept
+        {
+            return researchStations;
+        }
+
+        const playerDeck& getPlayerDeck() const noexcept
+        {
+            return pDeck;
+        }
+
+        const infectionDeck& getInfectionDeck() const noexcept
+        {
+            return iDeck;
+        }
+
+        const std::array<City, numCities>& getCities() const noexcept
+        {
+            return cities;
+        }
+
+        const std::array<Disease, numDiseases>& getDiseases() const noexcept
+        {
+            return diseases;
+        }
+};
+#endif
\ No newline at end of file
@@ -90,12 +90,21 @@ enum class Roles : char
     scientist = 'S'
 };
 
-std::ostream& operator<<(std::ostream& lhs, Color rhs)
+enum class Outcome : int_fast16_t
+{
+    ongoing,
+    won,
+    outbreakLoss,
+    cubeLoss,
+    playerDeckLoss
+};
+
+inline std::ostream& operator<<(std::ostream& lhs, Color rhs)
 {
     return lhs << static_cast<int_fast16_t>(rhs);
 }
 
-std::ostream& operator<<(std::ostream& lhs, Roles rhs)
+inline std::ostream& operator<<(std::ostream& lhs, Roles rhs)
 {
     return lhs << static_cast<char>(rhs);
 }
@@ -112,6 +121,7 @@ inline constexpr std::int_fast16_t numDiseases = 4;
 inline constexpr std::int_fast16_t diseaseCubesPerColor = 24;
 inline constexpr std::int_fast16_t maxOutbreaks = 7;
 inline constexpr std::int_fast16_t maxInfection = 4;
+inline constexpr std::int_fast16_t numOutcomes = 5;
 
 // Infection Rate Constants
 inline constexpr std::int_fast16_t minInfectionRate = 2;
@@ -131,11 +141,23 @@ inline constexpr std::int_fast16_t cardsIfFour = 2;
 inline constexpr std::int_fast16_t numWaves = 3;
 inline constexpr std::int_fast16_t strongestWave = 3;
 inline constexpr std::int_fast16_t citiesPerWave = 3;
+inline constexpr std::int_fast16_t cardsDrawnPerTurn = 2;
+inline constexpr std::int_fast16_t epidemicInfection = 3;
+// A tilt t multiplies the mean squared likelihood ratio by about
+// (sinh(t / 2) / (t / 2))^2 per pile, 1.09 at 1 but 11 at 6
+inline constexpr double maxEpidemicTilt = 1.0;
 
 // Player Constants
 inline constexpr std::int_fast16_t maxCards = 7;
+inline constexpr std::int_fast16_t actionsPerTurn = 4;
+inline constexpr std::int_fast16_t cardsToCure = 5;
+inline constexpr std::int_fast16_t scientistCardsToCure = 4;
+inline constexpr std::int_fast16_t bitsInByte = 8;
+inline constexpr std::int_fast64_t roleMask = 255;
+inline constexpr std::int_fast64_t defaultRoles = static_cast<int_fast64_t>('C' << 24) + static_cast<int_fast64_t>('C' << 16) + static_cast<int_fast64_t>('C' << 8) + static_cast<int_fast64_t>('C');
 
 // City Constants
+inline constexpr std::int_fast16_t citiesPerColor = numCities / numDiseases;
 inline constexpr std::array<int_fast32_t, numCities> cityPopulations = 
 {
 	// blue cities
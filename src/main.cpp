@@ -1,4 +1,11 @@
-#include "game.h"
+#include "batch.h"
+#include "server.h"
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
 
 inline int getIntFromUser(const std::string& message) 
 {
@@ -18,17 +25,299 @@ inline int getIntFromUser(const std::string& message)
     return result;
 }
 
+inline constexpr const char* usage =
+    "usage: pandemic_game_simulator [--games n] [--seed s] [--threads t] [--checkpoint file] [--checkpoint-interval seconds]\n"
+    "                               [--policy passive|greedy] [--epidemic-tilt t[,t...] (each -1..1)]\n"
+    "                               [--shard i/n] [--output file|-] [--processes n] [--setup-cache file]\n"
+    "       pandemic_game_simulator --merge result...\n"
+    "       pandemic_game_simulator --serve -|socket\n";
+
+inline bool readResult(std::istream& in, const std::string& name, std::vector<ShardResult>& results)
+{
+    ShardResult result;
+    if (!result.load(in))
+    {
+        std::cerr << "Could not read result " << name << '\n';
+        return false;
+    }
+    results.push_back(result);
+    return true;
+}
+
+// One tilt for every pile, or one per pile from the top
+inline bool readTilts(std::stringstream& value, SamplingBias& bias)
+{
+    std::vector<double> tilts;
+    double tilt = 0.0;
+    char separator = ',';
+    while (separator == ',' && value >> tilt)
+    {
+        tilts.push_back(tilt);
+        separator = 0;
+        value >> separator;
+    }
+    if (tilts.size() == 1)
+        bias.epidemicTilts.fill(tilts.front());
+    else if (tilts.size() == bias.epidemicTilts.size())
+        std::copy(tilts.begin(), tilts.end(), bias.epidemicTilts.begin());
+    else
+        return false;
+    return value.eof() && std::all_of(tilts.begin(), tilts.end(), [](double t){ return std::abs(t) <= maxEpidemicTilt; });
+}
+
+inline int report(const ShardResult& result, const std::string& outputPath)
+{
+    if (outputPath == "-")
+    {
+        result.save(std::cout);
+        return std::cout.flush() ? 0 : 1;
+    }
+    if (!outputPath.empty())
+    {
+        std::ofstream out{outputPath, std::ios::trunc};
+        result.save(out);
+        if (!out.flush())
+        {
+            std::cerr << "Could not write result " << outputPath << '\n';
+            return 1;
+        }
+    }
+    std::cout << result.statistics;
+    return 0;
+}
+
+// Starts one worker with its stdout on a pipe. Returns the read end of the
+// pipe, or -1 if the worker could not be started.
+inline int spawnWorker(const std::vector<std::string>& arguments, pid_t& worker)
+{
+    int ends[2];
+    if (::pipe(ends) != 0)
+        return -1;
+    // Later workers must not inherit the pipes of earlier ones
+    ::fcntl(ends[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+    std::vector<char*> argv;
+    for (const std::string& argument : arguments)
+    {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, ends[1], STDOUT_FILENO);
+    bool spawned = ::posix_spawnp(&worker, argv.front(), &actions, nullptr, argv.data(), environ) == 0;
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(ends[1]);
+    if (spawned)
+        return ends[0];
+    ::close(ends[0]);
+    return -1;
+}
+
+// Runs every shard in its own worker process and reads the results back over
+// pipes. The threads are split between the workers.
+inline std::optional<ShardResult> runProcesses(const std::string& executable, uint_fast64_t processes, uint_fast64_t games, uint_fast64_t firstSeed
+                                                , uint_fast64_t threads, const std::string& policy, const std::string& tilts
+                                                , const std::string& checkpointPath, double checkpointInterval, const std::string& cachePath)
+{
+    uint_fast64_t workerThreads = std::max<uint_fast64_t>(1, threads / processes);
+    std::vector<int> pipes;
+    std::vector<pid_t> workers(processes, -1);
+    for (uint_fast64_t process = 0; process < processes; ++process)
+    {
+        std::vector<std::string> arguments{executable, "--games", std::to_string(games), "--seed", std::to_string(firstSeed)
+                                           , "--threads", std::to_string(workerThreads), "--policy", policy
+                                           , "--shard", std::to_string(process) + '/' + std::to_string(processes), "--output", "-"};
+        if (!tilts.empty())
+            arguments.insert(arguments.end(), {"--epidemic-tilt", tilts});
+        if (!checkpointPath.empty())
+        {
+            std::stringstream interval{};
+            interval << std::setprecision(std::numeric_limits<double>::max_digits10) << checkpointInterval;
+            arguments.insert(arguments.end(), {"--checkpoint", checkpointPath + '.' + std::to_string(process), "--checkpoint-interval", interval.str()});
+        }
+        if (!cachePath.empty())
+            arguments.insert(arguments.end(), {"--setup-cache", cachePath});
+        pipes.push_back(spawnWorker(arguments, workers[process]));
+    }
+    std::vector<ShardResult> results;
+    bool succeeded = true;
+    for (uint_fast64_t process = 0; process < processes; ++process)
+    {
+        std::string output{};
+        std::array<char, 4096> buffer;
+        ssize_t bytes = 0;
+        while (pipes[process] >= 0 && ((bytes = ::read(pipes[process], buffer.data(), buffer.size())) > 0 || (bytes < 0 && errno == EINTR)))
+        {
+            if (bytes > 0)
+                output.append(buffer.data(), bytes);
+        }
+        int status = -1;
+        if (pipes[process] >= 0)
+        {
+            ::close(pipes[process]);
+            while (::waitpid(workers[process], &status, 0) < 0 && errno == EINTR);
+        }
+        std::stringstream in{output};
+        std::stringstream name{};
+        name << "of shard " << process;
+        succeeded = pipes[process] >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0 && readResult(in, name.str(), results) && succeeded;
+    }
+    if (!succeeded)
+        return std::nullopt;
+    return mergeResults(results);
+}
+
 int main(int argc, char *argv[]) 
 {
-    constexpr int_fast64_t roles = static_cast<int_fast64_t>('C' << 24) + static_cast<int_fast64_t>('C' << 16) + static_cast<int_fast64_t>('C' << 8) + static_cast<int_fast64_t>('C');
-    std::vector<Game<roles>> games;
-    constexpr int_fast16_t gamesAtOnce = 1000;
-    games.reserve(gamesAtOnce);
+    constexpr int_fast64_t roles = defaultRoles;
+    uint_fast64_t games = 1000;
+    uint_fast64_t firstSeed = 0;
+    uint_fast64_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string checkpointPath{};
+    double checkpointInterval = 60.0;
+    uint_fast64_t shard = 0;
+    uint_fast64_t shards = 1;
+    uint_fast64_t processes = 0;
+    std::string outputPath{};
+    std::string policy{"passive"};
+    std::string tilts{};
+    SamplingBias bias{};
+    std::vector<std::string> mergePaths{};
+    std::string servePath{};
+    std::string cachePath{};
+    for (int argument = 1; argument < argc; argument += 2)
+    {
+        std::string option{argv[argument]};
+        std::stringstream value{argument + 1 < argc ? argv[argument + 1] : ""};
+        bool validInput = false;
+        char separator = 0;
+        if (option == "--games")
+            validInput = static_cast<bool>(value >> games);
+        else if (option == "--seed")
+            validInput = static_cast<bool>(value >> firstSeed);
+        else if (option == "--threads")
+            validInput = value >> threads && threads > 0;
+        else if (option == "--checkpoint")
+        {
+            checkpointPath = value.str();
+            validInput = !checkpointPath.empty();
+        }
+        else if (option == "--checkpoint-interval")
+            validInput = static_cast<bool>(value >> checkpointInterval);
+        else if (option == "--shard")
+            validInput = value >> shard >> separator >> shards && separator == '/' && shard < shards;
+        else if (option == "--policy")
+            validInput = value >> policy && (policy == "passive" || policy == "greedy");
+        else if (option == "--epidemic-tilt")
+        {
+            tilts = value.str();
+            validInput = readTilts(value, bias);
+        }
+        else if (option == "--output")
+        {
+            outputPath = value.str();
+            validInput = !outputPath.empty();
+        }
+        else if (option == "--processes")
+            validInput = value >> processes && processes > 0;
+        else if (option == "--setup-cache")
+        {
+            cachePath = value.str();
+            validInput = !cachePath.empty();
+        }
+        else if (option == "--serve")
+        {
+            servePath = value.str();
+            validInput = !servePath.empty();
+        }
+        else if (option == "--merge")
+        {
+            mergePaths.assign(argv + argument + 1, argv + argc);
+            validInput = !mergePaths.empty();
+            argument = argc;
+        }
+        if (!validInput)
+        {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    // Step server for external agents on stdin and stdout or on a Unix socket
+    if (!servePath.empty())
+    {
+        StepServer<roles> server;
+        if (servePath == "-")
+            return server.serve(STDIN_FILENO, STDOUT_FILENO) ? 0 : 1;
+        server.serveSocket(servePath);
+        std::cerr << "Could not serve on " << servePath << '\n';
+        return 1;
+    }
+
+    if (!mergePaths.empty())
+    {
+        std::vector<ShardResult> results;
+        for (const std::string& path : mergePaths)
+        {
+            std::ifstream in{path};
+            if (!readResult(in, path, results))
+                return 1;
+        }
+        std::optional<ShardResult> merged = mergeResults(results);
+        if (!merged)
+        {
+            std::cerr << "Results do not cover every seed of one run exactly once\n";
+            return 1;
+        }
+        return report(*merged, outputPath);
+    }
+
+    // Every shard maps the cache of the whole run. It is created here, before
+    // any worker process opens it.
+    std::optional<SetupCache> cache{};
+    if (!cachePath.empty())
+    {
+        cache.emplace(cachePath, firstSeed, games, bias.epidemicTilts);
+        if (!cache->isOpen())
+        {
+            std::cerr << "Setup cache " << cachePath << " does not belong to this run\n";
+            return 1;
+        }
+    }
+
     Timer t;
-    for (uint_fast16_t i = 0; i < gamesAtOnce; ++i)
+    if (processes > 0)
     {
-        games.emplace_back(Game<roles>{i});
+        std::optional<ShardResult> merged = runProcesses(argv[0], processes, games, firstSeed, threads, policy, tilts, checkpointPath, checkpointInterval, cachePath);
+        if (!merged)
+        {
+            std::cerr << "A worker process failed\n";
+            return 1;
+        }
+        int status = report(*merged, outputPath);
+        std::cout << "Time elapsed: " << t.elapsed() << " seconds\n";
+        return status;
     }
-    std::cout << "Time elapsed: " << t.elapsed() << " seconds\n";
-    return 0;
-}
\ No newline at end of file
+
+    auto [shardSeed, shardGames] = shardRange(firstSeed, games, shard, shards);
+    Checkpoint progress{shardSeed, shardGames, policy, bias};
+    if (!checkpointPath.empty() && std::filesystem::exists(checkpointPath))
+    {
+        if (!progress.load(std::filesystem::path{checkpointPath}))
+        {
+            std::cerr << "Checkpoint " << checkpointPath << " does not belong to this run\n";
+            return 1;
+        }
+        std::cerr << "Resuming after " << progress.statistics.games() << " games\n";
+    }
+    SetupCache* setupCache = cache ? &*cache : nullptr;
+    if (policy == "greedy")
+        runGames<roles, GreedyPolicy>(progress, threads, checkpointPath, checkpointInterval, setupCache);
+    else
+        runGames<roles, PassivePolicy>(progress, threads, checkpointPath, checkpointInterval, setupCache);
+    int status = report(ShardResult{shardSeed, shardGames, progress.statistics, firstSeed, games, policy, bias}, outputPath);
+    if (outputPath != "-")
+        std::cout << "Time elapsed: " << t.elapsed() << " seconds\n";
+    return status;
+}
@@ -0,0 +1,55 @@
+#include "pandemic.h"
+#include "batch.h"
+
+static_assert(PANDEMIC_EPIDEMIC_PILES == gameDifficulty);
+
+template <class Policy>
+void playBatch(uint_fast64_t firstSeed, const SamplingBias& bias, pandemic_result* results, size_t count, uint_fast64_t threads)
+{
+    size_t chunks = (count + gamesPerChunk - 1) / gamesPerChunk;
+    std::atomic<size_t> nextChunk{0};
+    runOnThreads(threads, [&]()
+    {
+        for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+        {
+            for (size_t game = chunk * gamesPerChunk, end = std::min<size_t>(count, (chunk + 1) * gamesPerChunk); game < end; ++game)
+            {
+                GameResult result = Game<defaultRoles, Policy>{firstSeed + game, Policy{}, bias}.play();
+                results[game] = pandemic_result{firstSeed + game, static_cast<int16_t>(result.outcome), static_cast<int16_t>(result.turns)
+                                                , static_cast<int16_t>(result.outbreaks), static_cast<int16_t>(result.epidemics), result.likelihoodRatio};
+            }
+        }
+    });
+}
+
+extern "C" int pandemic_run_batch(const pandemic_config* config, pandemic_result* results, size_t count)
+{
+    if (!config || (!results && count > 0))
+        return PANDEMIC_INVALID_ARGUMENT;
+    uint_fast64_t threads = config->threads > 0 ? config->threads : std::max(1u, std::thread::hardware_concurrency());
+    SamplingBias bias;
+    for (int_fast16_t pile = 0; pile < gameDifficulty; ++pile)
+    {
+        if (!(std::abs(config->epidemic_tilts[pile]) <= maxEpidemicTilt))
+            return PANDEMIC_INVALID_ARGUMENT;
+        bias.epidemicTilts[pile] = config->epidemic_tilts[pile];
+    }
+    threads = std::min<uint_fast64_t>(threads, (count + gamesPerChunk - 1) / gamesPerChunk);
+    try
+    {
+        switch (config->policy)
+        {
+            case PANDEMIC_POLICY_PASSIVE:
+                playBatch<PassivePolicy>(config->first_seed, bias, results, count, threads);
+                return PANDEMIC_OK;
+            case PANDEMIC_POLICY_GREEDY:
+                playBatch<GreedyPolicy>(config->first_seed, bias, results, count, threads);
+                return PANDEMIC_OK;
+        }
+    }
+    catch (...)
+    {
+        return PANDEMIC_INTERNAL_ERROR;
+    }
+    return PANDEMIC_INVALID_ARGUMENT;
+}
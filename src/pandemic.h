@@ -0,0 +1,69 @@
+/* C interface to the simulator for running batches of games in-process */
+#ifndef PANDEMIC_H
+#define PANDEMIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Piles the epidemic cards are shuffled into, the game difficulty */
+#define PANDEMIC_EPIDEMIC_PILES 4
+
+enum pandemic_policy
+{
+    PANDEMIC_POLICY_PASSIVE = 0,
+    PANDEMIC_POLICY_GREEDY = 1
+};
+
+/* Same values as Outcome in gameConstants.h */
+enum pandemic_outcome
+{
+    PANDEMIC_OUTCOME_WON = 1,
+    PANDEMIC_OUTCOME_OUTBREAK_LOSS = 2,
+    PANDEMIC_OUTCOME_CUBE_LOSS = 3,
+    PANDEMIC_OUTCOME_PLAYER_DECK_LOSS = 4
+};
+
+enum pandemic_status
+{
+    PANDEMIC_OK = 0,
+    PANDEMIC_INVALID_ARGUMENT = -1,
+    PANDEMIC_INTERNAL_ERROR = -2
+};
+
+struct pandemic_config
+{
+    uint64_t first_seed;
+    int32_t policy;
+    /* Worker threads, 0 uses one per hardware thread */
+    uint32_t threads;
+    /* Importance sampling of epidemic positions per pile from the top, each
+       within -1 .. 1, all zero plays unbiased games (see
+       playerDeck::prepareDeck) */
+    double epidemic_tilts[PANDEMIC_EPIDEMIC_PILES];
+};
+
+struct pandemic_result
+{
+    uint64_t seed;
+    int16_t outcome;
+    int16_t turns;
+    int16_t outbreaks;
+    int16_t epidemics;
+    /* Weight of the game in unbiased estimates, 1 without importance sampling */
+    double likelihood_ratio;
+};
+
+/* Plays the games seeded first_seed .. first_seed + count - 1 and writes the
+   result of game i to results[i]. The caller owns the results buffer.
+   Returns PANDEMIC_OK or a negative pandemic_status. */
+int pandemic_run_batch(const struct pandemic_config* config, struct pandemic_result* results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,8 @@
 #include "deck.h"
 #include <bitset>
 
+#ifndef PLAYERS
+#define PLAYERS
 
 class Player
 {
@@ -30,6 +32,37 @@ class Player
             :role{r}
         {}
 
+        Cities getLocation() const
+        {
+            return location;
+        }
+
+        void setLocation(const Cities city)
+        {
+            location = city;
+        }
+
+        Roles getRole() const
+        {
+            return role;
+        }
+
+        const std::bitset<numPlayerCards>& getCards() const
+        {
+            return cards;
+        }
+
+        // Lowest numbered card in the hand, or epidemicCard for an empty hand
+        int_fast16_t firstCard() const
+        {
+            for (int_fast16_t i = 0; i < numPlayerCards; ++i)
+            {
+                if (cards.test(i))
+                    return i;
+            }
+            return epidemicCard;
+        }
+
         int_fast32_t maxPopulation() const
         {
             int_fast32_t result{0};
@@ -55,4 +88,5 @@ class Player
         {
             cards.reset(card.getNumber<int_fast16_t>());
         }
-};
\ No newline at end of file
+};
+#endif
\ No newline at end of file
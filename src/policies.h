@@ -0,0 +1,293 @@
+#include "gameConstants.h"
+#include "cities.h"
+#include "deck.h"
+#include "players.h"
+#include <concepts>
+#include <memory>
+#include <optional>
+
+#ifndef POLICIES
+#define POLICIES
+
+enum class ActionType : int_fast16_t
+{
+    pass,
+    drive,
+    directFlight,
+    treat,
+    buildResearchStation,
+    discoverCure
+};
+
+// Destination of drive and direct flight, color of treat and discover cure
+struct Action
+{
+    ActionType type{ActionType::pass};
+    Cities city{Cities::atlanta};
+    Color color{Color::blue};
+};
+
+// Event card played by the player holding it. The target is the city the
+// holder is airlifted to, the city given a research station, or the city
+// removed from the infection discard pile.
+struct EventPlay
+{
+    Events event{Events::oneQuietNight};
+    int_fast16_t player{0};
+    Cities target{Cities::atlanta};
+};
+
+// Decisions a Game asks of its policy. Policies are template parameters of
+// Game, so built-in heuristics are inlined into the game loop.
+template <class P, class G>
+concept AgentPolicy = requires(P& policy, const G& game, int_fast16_t player)
+{
+    { policy.chooseAction(game, player) } -> std::same_as<Action>;
+    { policy.chooseDiscard(game, player) } -> std::same_as<playerCard>;
+    { policy.chooseEvent(game) } -> std::same_as<std::optional<EventPlay>>;
+};
+
+// Shortest number of drives between every pair of cities
+inline std::array<std::array<int_fast16_t, numCities>, numCities> computeCityDistances()
+{
+    std::array<std::array<int_fast16_t, numCities>, numCities> result;
+    for (int_fast16_t start = 0; start < numCities; ++start)
+    {
+        result[start].fill(numCities);
+        result[start][start] = 0;
+        std::array<int_fast16_t, numCities> queue{static_cast<int_fast16_t>(start)};
+        for (int_fast16_t head = 0, tail = 1; head < tail; ++head)
+        {
+            for (Cities neighbor : cityConnections[queue[head]])
+            {
+                int_fast16_t next = static_cast<int_fast16_t>(neighbor);
+                if (result[start][next] == numCities)
+                {
+                    result[start][next] = result[start][queue[head]] + 1;
+                    queue[tail++] = next;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+inline const std::array<std::array<int_fast16_t, numCities>, numCities> cityDistances = computeCityDistances();
+
+// Takes no actions and plays no events
+class PassivePolicy
+{
+    public:
+
+        static constexpr const char* name = "passive";
+
+        template <class G>
+        Action chooseAction(const G&, int_fast16_t) noexcept
+        {
+            return Action{};
+        }
+
+        template <class G>
+        playerCard chooseDiscard(const G& game, int_fast16_t player) noexcept
+        {
+            return playerCard{game.getPlayers()[player].firstCard()};
+        }
+
+        template <class G>
+        std::optional<EventPlay> chooseEvent(const G&) noexcept
+        {
+            return std::nullopt;
+        }
+};
+
+// Cures whenever it can, otherwise treats the current city, walks toward a
+// research station once it holds enough cards for a cure, and otherwise
+// drives to the most infected neighbor
+class GreedyPolicy
+{
+    private:
+
+        static int_fast16_t colorCount(const Player& player, Color color) noexcept
+        {
+            int_fast16_t result = 0;
+            for (int_fast16_t city = static_cast<int_fast16_t>(color) * citiesPerColor, end = city + citiesPerColor; city < end; ++city)
+            {
+                result += player.getCards().test(city);
+            }
+            return result;
+        }
+
+        static int_fast16_t cubesAt(const City& city) noexcept
+        {
+            int_fast16_t result = 0;
+            for (int_fast16_t color = 0; color < numDiseases; ++color)
+            {
+                result += city.getInfectionCount(static_cast<Color>(color));
+            }
+            return result;
+        }
+
+    public:
+
+        static constexpr const char* name = "greedy";
+
+        template <class G>
+        Action chooseAction(const G& game, int_fast16_t player) noexcept
+        {
+            const Player& p = game.getPlayers()[player];
+            int_fast16_t here = static_cast<int_fast16_t>(p.getLocation());
+            bool readyToCure = false;
+            for (int_fast16_t color = 0; color < numDiseases; ++color)
+            {
+                Action cure{ActionType::discoverCure, p.getLocation(), static_cast<Color>(color)};
+                if (game.isLegal(cure, player))
+                    return cure;
+                readyToCure = readyToCure || (!game.isCured(static_cast<Color>(color)) && colorCount(p, static_cast<Color>(color)) >= game.cardsToCure(player));
+            }
+
+            const City& city = game.getCities()[here];
+            Action treat{ActionType::treat, p.getLocation(), Color::blue};
+            for (int_fast16_t color = 1; color < numDiseases; ++color)
+            {
+                if (city.getInfectionCount(static_cast<Color>(color)) > city.getInfectionCount(treat.color))
+                    treat.color = static_cast<Color>(color);
+            }
+            if (city.getInfectionCount(treat.color) > 0 && !readyToCure)
+                return treat;
+
+            Action drive{ActionType::pass};
+            int_fast16_t best = 0;
+            for (Cities neighbor : city.getAdjacentCities())
+            {
+                int_fast16_t score = cubesAt(game.getCities()[static_cast<int_fast16_t>(neighbor)]);
+                if (readyToCure)
+                {
+                    int_fast16_t closest = numCities;
+                    for (Cities station : game.getResearchStations())
+                    {
+                        closest = std::min(closest, cityDistances[static_cast<int_fast16_t>(neighbor)][static_cast<int_fast16_t>(station)]);
+                    }
+                    score = numCities - closest;
+                }
+                if (score > best)
+                {
+                    best = score;
+                    drive = Action{ActionType::drive, neighbor};
+                }
+            }
+            return drive;
+        }
+
+        // Keeps the colors the player is collecting, events go last
+        template <class G>
+        playerCard chooseDiscard(const G& game, int_fast16_t player) noexcept
+        {
+            const Player& p = game.getPlayers()[player];
+            int_fast16_t result = -1;
+            int_fast16_t fewest = numPlayerCards;
+            for (int_fast16_t card = 0; card < numCityCards; ++card)
+            {
+                int_fast16_t count = colorCount(p, static_cast<Color>(card / citiesPerColor));
+                if (p.getCards().test(card) && (count < fewest || game.isCured(static_cast<Color>(card / citiesPerColor))))
+                {
+                    result = card;
+                    fewest = game.isCured(static_cast<Color>(card / citiesPerColor)) ? 0 : count;
+                }
+            }
+            return playerCard{result >= 0 ? result : p.firstCard()};
+        }
+
+        // Holds One Quiet Night back until the infection rate has risen
+        template <class G>
+        std::optional<EventPlay> chooseEvent(const G& game) noexcept
+        {
+            if (game.infectionRate() <= minInfectionRate)
+                return std::nullopt;
+            for (int_fast16_t player = 0; player < numPlayers; ++player)
+            {
+                if (game.getPlayers()[player].getCards().test(static_cast<int_fast16_t>(Events::oneQuietNight)))
+                    return EventPlay{Events::oneQuietNight, player};
+            }
+            return std::nullopt;
+        }
+};
+
+template <int_fast64_t roles, class Policy>
+class Game;
+
+template <int_fast64_t roles>
+class RuntimePolicy;
+
+// Interface for agents chosen at run time, at the cost of a virtual call per decision
+template <int_fast64_t roles>
+class Agent
+{
+    public:
+
+        virtual ~Agent() = default;
+        virtual Action chooseAction(const Game<roles, RuntimePolicy<roles>>& game, int_fast16_t player) = 0;
+        virtual playerCard chooseDiscard(const Game<roles, RuntimePolicy<roles>>& game, int_fast16_t player) = 0;
+        virtual std::optional<EventPlay> chooseEvent(const Game<roles, RuntimePolicy<roles>>& game) = 0;
+};
+
+template <int_fast64_t roles, class Policy>
+class PolicyAgent : public Agent<roles>
+{
+    private:
+
+        Policy policy;
+
+    public:
+
+        PolicyAgent(Policy p = Policy{})
+            : policy{p}
+        {}
+
+        Action chooseAction(const Game<roles, RuntimePolicy<roles>>& game, int_fast16_t player)
+        {
+            return policy.chooseAction(game, player);
+        }
+
+        playerCard chooseDiscard(const Game<roles, RuntimePolicy<roles>>& game, int_fast16_t player)
+        {
+            return policy.chooseDiscard(game, player);
+        }
+
+        std::optional<EventPlay> chooseEvent(const Game<roles, RuntimePolicy<roles>>& game)
+        {
+            return policy.chooseEvent(game);
+        }
+};
+
+// Type-erased policy forwarding every decision to a shared Agent
+template <int_fast64_t roles>
+class RuntimePolicy
+{
+    private:
+
+        std::shared_ptr<Agent<roles>> agent;
+
+    public:
+
+        static constexpr const char* name = "runtime";
+
+        RuntimePolicy(std::shared_ptr<Agent<roles>> a = std::make_shared<PolicyAgent<roles, PassivePolicy>>())
+            : agent{std::move(a)}
+        {}
+
+        Action chooseAction(const Game<roles, RuntimePolicy>& game, int_fast16_t player)
+        {
+            return agent->chooseAction(game, player);
+        }
+
+        playerCard chooseDiscard(const Game<roles, RuntimePolicy>& game, int_fast16_t player)
+        {
+            return agent->chooseDiscard(game, player);
+        }
+
+        std::optional<EventPlay> chooseEvent(const Game<roles, RuntimePolicy>& game)
+        {
+            return agent->chooseEvent(game);
+        }
+};
+#endif
@@ -0,0 +1,488 @@
+#include "game.h"
+#include <cerrno>
+#include <coroutine>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef SERVER
+#define SERVER
+
+// Step protocol for external agents. A request message is a uint32_t count
+// followed by that many StepRequests, the reply is a uint32_t count followed
+// by one Observation per request in the same order. All fields are in host
+// byte order.
+
+// Action indices of an action decision
+inline constexpr int_fast16_t passAction = 0;
+inline constexpr int_fast16_t driveActions = passAction + 1;
+inline constexpr int_fast16_t directFlightActions = driveActions + numCities;
+inline constexpr int_fast16_t treatActions = directFlightActions + numCities;
+inline constexpr int_fast16_t buildResearchStationAction = treatActions + numDiseases;
+inline constexpr int_fast16_t discoverCureActions = buildResearchStationAction + 1;
+inline constexpr int_fast16_t airliftActions = discoverCureActions + numDiseases;
+inline constexpr int_fast16_t governmentGrantActions = airliftActions + numCities;
+inline constexpr int_fast16_t oneQuietNightAction = governmentGrantActions + numCities;
+inline constexpr int_fast16_t resilientPopulationActions = oneQuietNightAction + 1;
+inline constexpr int_fast16_t numStepActions = resilientPopulationActions + numCities;
+inline constexpr int_fast16_t legalMaskBytes = 32;
+inline constexpr uint8_t unknownEnvironment = 255;
+// Larger request messages drop the connection
+inline constexpr uint32_t maxStepBatch = 1 << 16;
+
+enum class Operation : uint8_t
+{
+    reset,
+    step,
+    close
+};
+
+// What the environment waits for. Action decisions take an action index, event
+// plays among them do not use up an action. Discard decisions take the card
+// number to discard. Event decisions come after the draws, before infection,
+// while someone can play an event: pass ends them, event indices play one.
+enum class Decision : uint8_t
+{
+    none,
+    action,
+    discard,
+    event
+};
+
+struct StepRequest
+{
+    uint64_t seed;
+    uint32_t environment;
+    uint16_t action;
+    Operation operation;
+    uint8_t reserved;
+};
+
+struct Observation
+{
+    uint64_t hands[numPlayers];
+    uint64_t researchStations;
+    uint64_t infectionDiscard;
+    uint32_t environment;
+    uint16_t turn;
+    uint8_t outcome;
+    Decision decision;
+    uint8_t player;
+    uint8_t actionsLeft;
+    uint8_t outbreaks;
+    uint8_t epidemics;
+    uint8_t infectionRate;
+    uint8_t cured;
+    uint8_t eradicated;
+    uint8_t playerCardsLeft;
+    uint8_t locations[numPlayers];
+    int8_t cubesLeft[numDiseases];
+    uint8_t cubes[numCities * numDiseases];
+    uint8_t legal[legalMaskBytes];
+};
+
+static_assert(sizeof(StepRequest) == 16);
+static_assert(sizeof(Observation) == 296);
+static_assert(numStepActions <= legalMaskBytes * bitsInByte);
+
+// Coroutine of one game, suspended whenever it waits for a decision
+class Episode
+{
+    public:
+
+        struct promise_type
+        {
+            Episode get_return_object() noexcept
+            {
+                return Episode{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept
+            {}
+
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+
+    private:
+
+        std::coroutine_handle<promise_type> handle;
+
+    public:
+
+        explicit Episode(std::coroutine_handle<promise_type> h) noexcept
+            : handle{h}
+        {}
+
+        Episode(Episode&& rhs) noexcept
+            : handle{std::exchange(rhs.handle, nullptr)}
+        {}
+
+        Episode& operator=(Episode&& rhs) noexcept
+        {
+            std::swap(handle, rhs.handle);
+            return *this;
+        }
+
+        ~Episode()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        void resume()
+        {
+            if (handle && !handle.done())
+                handle.resume();
+        }
+};
+
+// Player holding an event card, or the first player if nobody does
+template <class G>
+int_fast16_t eventHolder(const G& game, Events event) noexcept
+{
+    for (int_fast16_t player = 0; player < numPlayers; ++player)
+    {
+        if (game.getPlayers()[player].getCards().test(static_cast<int_fast16_t>(event)))
+            return player;
+    }
+    return 0;
+}
+
+template <class G>
+std::variant<Action, EventPlay> decodeAction(const G& game, uint16_t index) noexcept
+{
+    auto city = [](int_fast16_t offset){ return static_cast<Cities>(offset); };
+    auto color = [](int_fast16_t offset){ return static_cast<Color>(offset); };
+    auto event = [&](Events e, Cities target){ return EventPlay{e, eventHolder(game, e), target}; };
+    int_fast16_t i = index;
+    if (i >= resilientPopulationActions && i < numStepActions)
+        return event(Events::ResilientPopulation, city(i - resilientPopulationActions));
+    if (i == oneQuietNightAction)
+        return event(Events::oneQuietNight, Cities::atlanta);
+    if (i >= governmentGrantActions && i < oneQuietNightAction)
+        return event(Events::governmentGrant, city(i - governmentGrantActions));
+    if (i >= airliftActions && i < governmentGrantActions)
+        return event(Events::airlift, city(i - airliftActions));
+    if (i >= discoverCureActions && i < airliftActions)
+        return Action{ActionType::discoverCure, Cities::atlanta, color(i - discoverCureActions)};
+    if (i == buildResearchStationAction)
+        return Action{ActionType::buildResearchStation};
+    if (i >= treatActions && i < buildResearchStationAction)
+        return Action{ActionType::treat, Cities::atlanta, color(i - treatActions)};
+    if (i >= directFlightActions && i < treatActions)
+        return Action{ActionType::directFlight, city(i - directFlightActions)};
+    if (i >= driveActions && i < directFlightActions)
+        return Action{ActionType::drive, city(i - driveActions)};
+    return Action{};
+}
+
+template <int_fast64_t roles>
+class Environment
+{
+    private:
+
+        static Episode run(Environment& environment)
+        {
+            Game<roles>& game = environment.game;
+            while (!game.isOver())
+            {
+                environment.player = game.beginTurn();
+                environment.actionsLeft = actionsPerTurn;
+                while (environment.actionsLeft > 0 && !game.isOver())
+                {
+                    environment.decision = Decision::action;
+                    co_await std::suspend_always{};
+                    std::variant<Action, EventPlay> decoded = decodeAction(game, environment.reply);
+                    if (const EventPlay* event = std::get_if<EventPlay>(&decoded); event && game.playEvent(*event))
+                        continue;
+                    if (const Action* action = std::get_if<Action>(&decoded))
+                        game.takeAction(*action, environment.player);
+                    --environment.actionsLeft;
+                }
+                for (int_fast16_t card = 0; card < cardsDrawnPerTurn && !game.isOver(); ++card)
+                {
+                    game.drawPlayerCard(environment.player);
+                    while (game.overHandLimit(environment.player))
+                    {
+                        environment.decision = Decision::discard;
+                        co_await std::suspend_always{};
+                        game.discard(environment.player, playerCard{static_cast<int_fast16_t>(std::min<uint16_t>(environment.reply, numPlayerCards))});
+                    }
+                }
+                while (!game.isOver() && environment.canPlayEvent())
+                {
+                    environment.decision = Decision::event;
+                    co_await std::suspend_always{};
+                    std::variant<Action, EventPlay> decoded = decodeAction(game, environment.reply);
+                    const EventPlay* event = std::get_if<EventPlay>(&decoded);
+                    if (!event || !game.playEvent(*event))
+                        break;
+                }
+                game.endTurn();
+            }
+            environment.decision = Decision::none;
+        }
+
+        bool isLegal(uint16_t index) const noexcept
+        {
+            if (decision == Decision::discard)
+                return index < numPlayerCards && game.getPlayers()[player].getCards().test(index);
+            std::variant<Action, EventPlay> decoded = decodeAction(game, index);
+            if (const EventPlay* event = std::get_if<EventPlay>(&decoded))
+                return game.isLegal(*event);
+            if (decision == Decision::event)
+                return index == passAction;
+            return game.isLegal(std::get<Action>(decoded), player);
+        }
+
+        bool canPlayEvent() const noexcept
+        {
+            for (uint16_t index = airliftActions; index < numStepActions; ++index)
+            {
+                if (isLegal(index))
+                    return true;
+            }
+            return false;
+        }
+
+    public:
+
+        Game<roles> game;
+        Decision decision{Decision::none};
+        int_fast16_t player{0};
+        int_fast16_t actionsLeft{0};
+        uint16_t reply{0};
+        Episode episode;
+
+        // Runs the game up to its first decision. Environments must not move
+        // while their episode runs, so they live behind a pointer.
+        explicit Environment(uint64_t seed)
+            : game{seed}, episode{run(*this)}
+        {
+            episode.resume();
+        }
+
+        void step(uint16_t action)
+        {
+            reply = action;
+            episode.resume();
+        }
+
+        Observation observe(uint32_t id) const noexcept
+        {
+            Observation result{};
+            result.environment = id;
+            result.turn = game.getResult().turns;
+            result.outcome = static_cast<uint8_t>(game.getResult().outcome);
+            result.decision = decision;
+            result.player = player;
+            result.actionsLeft = actionsLeft;
+            result.outbreaks = game.getResult().outbreaks;
+            result.epidemics = game.getResult().epidemics;
+            result.infectionRate = game.infectionRate();
+            result.playerCardsLeft = game.getPlayerDeck().cardsLeft();
+            for (int_fast16_t p = 0; p < numPlayers; ++p)
+            {
+                result.hands[p] = game.getPlayers()[p].getCards().to_ullong();
+                result.locations[p] = static_cast<uint8_t>(game.getPlayers()[p].getLocation());
+            }
+            for (Cities station : game.getResearchStations())
+            {
+                result.researchStations |= uint64_t{1} << static_cast<int_fast16_t>(station);
+            }
+            const infectionDeck& deck = game.getInfectionDeck();
+            for (int_fast16_t card = deck.getDrawIndex() + 1; card < deck.getBackOfDeck(); ++card)
+            {
+                int_fast16_t city = deck.getCards()[card].getNumber<int_fast16_t>();
+                if (city < numCities)
+                    result.infectionDiscard |= uint64_t{1} << city;
+            }
+            for (int_fast16_t color = 0; color < numDiseases; ++color)
+            {
+                const Disease& disease = game.getDiseases()[color];
+                result.cured |= static_cast<uint8_t>(disease.isCured() << color);
+                result.eradicated |= static_cast<uint8_t>(disease.isEradicated() << color);
+                result.cubesLeft[color] = static_cast<int8_t>(disease.getCubesLeft());
+                for (int_fast16_t city = 0; city < numCities; ++city)
+                {
+                    result.cubes[city * numDiseases + color] = game.getCities()[city].getInfectionCount(static_cast<Color>(color));
+                }
+            }
+            if (decision != Decision::none)
+            {
+                for (uint16_t index = 0; index < numStepActions; ++index)
+                {
+                    if (isLegal(index))
+                        result.legal[index / bitsInByte] |= static_cast<uint8_t>(1 << (index % bitsInByte));
+                }
+            }
+            return result;
+        }
+};
+
+// Hosts any number of environments, each advanced one decision per step request
+template <int_fast64_t roles>
+class StepServer
+{
+    private:
+
+        std::unordered_map<uint32_t, std::unique_ptr<Environment<roles>>> environments;
+
+        static bool readAll(int fd, void* buffer, size_t bytes)
+        {
+            char* begin = static_cast<char*>(buffer);
+            while (bytes > 0)
+            {
+                ssize_t count = ::read(fd, begin, bytes);
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    return false;
+                begin += count;
+                bytes -= count;
+            }
+            return true;
+        }
+
+        // Sockets are written with MSG_NOSIGNAL, so a client that disconnects
+        // before reading its reply drops only its connection instead of
+        // raising SIGPIPE. Other descriptors, such as stdout, fall back to write.
+        static bool writeAll(int fd, const void* buffer, size_t bytes)
+        {
+            const char* begin = static_cast<const char*>(buffer);
+            bool socket = true;
+            while (bytes > 0)
+            {
+                ssize_t count = socket ? ::send(fd, begin, bytes, MSG_NOSIGNAL) : ::write(fd, begin, bytes);
+                if (count < 0 && socket && errno == ENOTSOCK)
+                {
+                    socket = false;
+                    continue;
+                }
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    return false;
+                begin += count;
+                bytes -= count;
+            }
+            return true;
+        }
+
+    public:
+
+        Observation handle(const StepRequest& request)
+        {
+            auto found = environments.find(request.environment);
+            switch (request.operation)
+            {
+                case Operation::reset:
+                {
+                    auto& environment = environments[request.environment];
+                    environment = std::make_unique<Environment<roles>>(request.seed);
+                    return environment->observe(request.environment);
+                }
+                case Operation::step:
+                    if (found == environments.end())
+                        break;
+                    found->second->step(request.action);
+                    return found->second->observe(request.environment);
+                case Operation::close:
+                    if (found == environments.end())
+                        break;
+                    Observation result = found->second->observe(request.environment);
+                    environments.erase(found);
+                    return result;
+            }
+            Observation unknown{};
+            unknown.environment = request.environment;
+            unknown.outcome = unknownEnvironment;
+            return unknown;
+        }
+
+        // Answers request messages until the input closes. Fails on a
+        // truncated message, a batch over maxStepBatch or a failed write.
+        bool serve(int in, int out)
+        {
+            std::vector<StepRequest> requests;
+            std::vector<Observation> observations;
+            uint32_t count = 0;
+            while (readAll(in, &count, sizeof(count)))
+            {
+                if (count > maxStepBatch)
+                    return false;
+                requests.resize(count);
+                observations.resize(count);
+                if (!readAll(in, requests.data(), count * sizeof(StepRequest)))
+                    return false;
+                for (uint32_t request = 0; request < count; ++request)
+                {
+                    observations[request] = handle(requests[request]);
+                }
+                if (!writeAll(out, &count, sizeof(count)) || !writeAll(out, observations.data(), count * sizeof(Observation)))
+                    return false;
+            }
+            return true;
+        }
+
+        // Serves one connection at a time on a Unix domain socket. A socket
+        // left at the path by an earlier server is replaced, any other file
+        // makes it fail. Returns only on failure.
+        bool serveSocket(const std::string& path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path))
+                return false;
+            std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            struct stat status;
+            if (::lstat(path.c_str(), &status) == 0)
+            {
+                if (!S_ISSOCK(status.st_mode) || ::unlink(path.c_str()) != 0)
+                    return false;
+            }
+            else if (errno != ENOENT)
+                return false;
+            int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listener < 0)
+                return false;
+            if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 1) != 0)
+            {
+                ::close(listener);
+                return false;
+            }
+            while (true)
+            {
+                int connection = ::accept(listener, nullptr, nullptr);
+                if (connection < 0 && errno == EINTR)
+                    continue;
+                if (connection < 0)
+                    break;
+                serve(connection, connection);
+                ::close(connection);
+                environments.clear();
+            }
+            ::close(listener);
+            return false;
+        }
+};
+#endif
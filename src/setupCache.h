@@ -0,0 +1,192 @@
+#include "deck.h"
+#include <atomic>
+#include <bitset>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SETUP_CACHE
+#define SETUP_CACHE
+
+inline constexpr char setupCacheMagic[16] = "pandemic-setup1";
+
+// Far more engine draws than any setup takes
+inline constexpr uint64_t maxSetupDraws = 1 << 16;
+
+// State of a game right after its setup. Hands and the initial infections
+// follow from the deck orders, and the engine of the seed continues from the
+// number of draws the setup took. Restoring skips the shuffles and the
+// epidemic placement, but the engine still generates the draws it skips.
+struct SetupRecord
+{
+    uint64_t draws;
+    double likelihoodRatio;
+    std::array<int8_t, numPlayerCards + gameDifficulty> playerCards;
+    std::array<int8_t, numCityCards> infectionCards;
+    uint8_t stored;
+};
+
+struct SetupCacheHeader
+{
+    char magic[sizeof(setupCacheMagic)];
+    uint64_t firstSeed;
+    uint64_t games;
+    uint64_t recordSize;
+    double epidemicTilts[gameDifficulty];
+};
+
+static_assert(sizeof(SetupRecord) == 128);
+static_assert(sizeof(SetupCacheHeader) % alignof(SetupRecord) == 0);
+
+// Memory-mapped file of setup records for the seeds firstSeed .. firstSeed +
+// games - 1, record i at the offset of seed firstSeed + i. Records are filled
+// in as games are set up, so any number of threads and processes can share one
+// cache and later runs over the same seeds skip most of their setup. With the
+// passive policy a warm cache saves about a twentieth of the run time.
+class SetupCache
+{
+    private:
+
+        int file{-1};
+        void* mapping{MAP_FAILED};
+        size_t bytes{0};
+        uint_fast64_t firstSeed;
+        uint_fast64_t games;
+        std::array<double, gameDifficulty> epidemicTilts;
+        SetupRecord* records{nullptr};
+
+        bool matches(const SetupCacheHeader& header) const noexcept
+        {
+            return std::memcmp(header.magic, setupCacheMagic, sizeof(setupCacheMagic)) == 0 && header.firstSeed == firstSeed
+                && header.games == games && header.recordSize == sizeof(SetupRecord)
+                && std::equal(epidemicTilts.begin(), epidemicTilts.end(), header.epidemicTilts);
+        }
+
+        // Writes an empty cache with its header under a temporary name, then
+        // links it into place. Processes racing to create the same cache never
+        // see a file without its header, and the first link wins. Succeeds if
+        // the file exists afterwards.
+        bool create(const std::filesystem::path& path) const
+        {
+            std::string temporary{path.string() + ".XXXXXX"};
+            int created = ::mkstemp(temporary.data());
+            if (created < 0)
+                return false;
+            SetupCacheHeader header{};
+            std::memcpy(header.magic, setupCacheMagic, sizeof(setupCacheMagic));
+            header.firstSeed = firstSeed;
+            header.games = games;
+            header.recordSize = sizeof(SetupRecord);
+            std::copy(epidemicTilts.begin(), epidemicTilts.end(), header.epidemicTilts);
+            bool written = ::fchmod(created, 0644) == 0 && ::ftruncate(created, bytes) == 0 && ::pwrite(created, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+            ::close(created);
+            bool linked = written && (::link(temporary.c_str(), path.c_str()) == 0 || errno == EEXIST);
+            ::unlink(temporary.c_str());
+            return linked;
+        }
+
+        // Decks that are not a reordering of the full decks, as left by a
+        // torn write or a damaged file, would set up an impossible game
+        static bool isValid(const SetupRecord& record) noexcept
+        {
+            std::bitset<numPlayerCards> playerSeen;
+            int_fast16_t epidemics = 0;
+            for (int8_t number : record.playerCards)
+            {
+                if (number == epidemicCard)
+                    ++epidemics;
+                else if (number < 0 || number >= numPlayerCards || playerSeen[number])
+                    return false;
+                else
+                    playerSeen[number] = true;
+            }
+            std::bitset<numCityCards> infectionSeen;
+            for (int8_t number : record.infectionCards)
+            {
+                if (number < 0 || number >= numCityCards || infectionSeen[number])
+                    return false;
+                infectionSeen[number] = true;
+            }
+            return epidemics == gameDifficulty && record.draws <= maxSetupDraws && std::isfinite(record.likelihoodRatio) && record.likelihoodRatio > 0.0;
+        }
+
+        SetupRecord* find(uint_fast64_t seed) const noexcept
+        {
+            if (!records || seed - firstSeed >= games)
+                return nullptr;
+            return records + (seed - firstSeed);
+        }
+
+    public:
+
+        // Creates the file if it does not exist. Fails, leaving the cache
+        // closed, if an existing file was made for other seeds or another bias.
+        SetupCache(const std::filesystem::path& path, uint_fast64_t first, uint_fast64_t count, const std::array<double, gameDifficulty>& tilts = {})
+            : bytes{sizeof(SetupCacheHeader) + count * sizeof(SetupRecord)}, firstSeed{first}, games{count}, epidemicTilts{tilts}
+        {
+            file = ::open(path.c_str(), O_RDWR);
+            if (file < 0 && errno == ENOENT && create(path))
+                file = ::open(path.c_str(), O_RDWR);
+            struct stat status;
+            if (file < 0 || ::fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) != bytes)
+                return;
+            mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+            if (mapping != MAP_FAILED && matches(*static_cast<const SetupCacheHeader*>(mapping)))
+                records = reinterpret_cast<SetupRecord*>(static_cast<char*>(mapping) + sizeof(SetupCacheHeader));
+        }
+
+        SetupCache(const SetupCache&) = delete;
+        SetupCache& operator=(const SetupCache&) = delete;
+
+        ~SetupCache()
+        {
+            if (mapping != MAP_FAILED)
+                ::munmap(mapping, bytes);
+            if (file >= 0)
+                ::close(file);
+        }
+
+        bool isOpen() const noexcept
+        {
+            return records != nullptr;
+        }
+
+        const std::array<double, gameDifficulty>& getEpidemicTilts() const noexcept
+        {
+            return epidemicTilts;
+        }
+
+        // The record of a seed, or nullptr if it has not been stored or is
+        // not a valid setup
+        const SetupRecord* lookup(uint_fast64_t seed) const noexcept
+        {
+            SetupRecord* record = find(seed);
+            if (!record || !std::atomic_ref<uint8_t>{record->stored}.load(std::memory_order_acquire) || !isValid(*record))
+                return nullptr;
+            return record;
+        }
+
+        // Seeds outside the cache are ignored and invalid records are
+        // replaced. The flag is set last, so a concurrent lookup never sees a
+        // partly written new record. Every writer of a seed writes the same
+        // record.
+        void store(uint_fast64_t seed, const SetupRecord& setup) noexcept
+        {
+            SetupRecord* record = find(seed);
+            if (!record || (std::atomic_ref<uint8_t>{record->stored}.load(std::memory_order_acquire) && isValid(*record)))
+                return;
+            record->draws = setup.draws;
+            record->likelihoodRatio = setup.likelihoodRatio;
+            record->playerCards = setup.playerCards;
+            record->infectionCards = setup.infectionCards;
+            std::atomic_ref<uint8_t>{record->stored}.store(1, std::memory_order_release);
+        }
+};
+#endif
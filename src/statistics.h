@@ -0,0 +1,347 @@
+#include "game.h"
+#include <cmath>
+#include <iomanip>
+
+#ifndef STATISTICS
+#define STATISTICS
+
+inline constexpr std::int_fast16_t maxTurns = (numPlayerCards + gameDifficulty) / cardsDrawnPerTurn + 1;
+
+inline constexpr std::array<const char*, numOutcomes> outcomeNames
+{
+    "ongoing",
+    "won",
+    "outbreak loss",
+    "cube loss",
+    "player deck loss"
+};
+
+// Exact counts of a small non-negative integer metric, values above maxValue
+// land in the last bin. Merging only adds counts, so every way of splitting a
+// run across threads produces the same histogram and the same summary.
+template <int_fast16_t maxValue>
+class Histogram
+{
+    private:
+
+        std::array<uint_fast64_t, maxValue + 1> counts{};
+
+    public:
+
+        void add(int_fast16_t value) noexcept
+        {
+            ++counts[std::clamp<int_fast16_t>(value, 0, maxValue)];
+        }
+
+        void merge(const Histogram& rhs) noexcept
+        {
+            for (int_fast16_t value = 0; value <= maxValue; ++value)
+            {
+                counts[value] += rhs.counts[value];
+            }
+        }
+
+        uint_fast64_t count() const noexcept
+        {
+            return std::accumulate(counts.begin(), counts.end(), uint_fast64_t{0});
+        }
+
+        double mean() const noexcept
+        {
+            uint_fast64_t n = count();
+            uint_fast64_t sum = 0;
+            for (int_fast16_t value = 0; value <= maxValue; ++value)
+            {
+                sum += counts[value] * value;
+            }
+            return n == 0 ? 0.0 : static_cast<double>(sum) / n;
+        }
+
+        double variance() const noexcept
+        {
+            uint_fast64_t n = count();
+            if (n < 2)
+                return 0.0;
+            double average = mean();
+            double sumOfSquares = 0.0;
+            for (int_fast16_t value = 0; value <= maxValue; ++value)
+            {
+                sumOfSquares += counts[value] * (value - average) * (value - average);
+            }
+            return sumOfSquares / (n - 1);
+        }
+
+        // Smallest value with at least the given fraction of the counts at or below it
+        int_fast16_t quantile(double fraction) const noexcept
+        {
+            uint_fast64_t target = static_cast<uint_fast64_t>(std::ceil(fraction * count()));
+            uint_fast64_t seen = 0;
+            for (int_fast16_t value = 0; value <= maxValue; ++value)
+            {
+                seen += counts[value];
+                if (seen >= target && seen > 0)
+                    return value;
+            }
+            return maxValue;
+        }
+
+        void save(std::ostream& out) const
+        {
+            for (uint_fast64_t count : counts)
+            {
+                out << count << ' ';
+            }
+        }
+
+        bool load(std::istream& in)
+        {
+            for (uint_fast64_t& count : counts)
+            {
+                in >> count;
+            }
+            return static_cast<bool>(in);
+        }
+
+        bool operator==(const Histogram& rhs) const = default;
+};
+
+// Sum of non-negative reals kept in 128-bit fixed point, so that like the
+// histograms it merges exactly in any order
+class FixedSum
+{
+    private:
+
+        static constexpr int fractionBits = 40;
+        static constexpr int wordBits = 64;
+        unsigned __int128 total{0};
+
+    public:
+
+        void add(double value) noexcept
+        {
+            total += static_cast<unsigned __int128>(std::ldexp(value, fractionBits) + 0.5);
+        }
+
+        void merge(const FixedSum& rhs) noexcept
+        {
+            total += rhs.total;
+        }
+
+        double value() const noexcept
+        {
+            return std::ldexp(static_cast<double>(total), -fractionBits);
+        }
+
+        // Whether the sum is exactly count ones
+        bool equalsCount(uint_fast64_t count) const noexcept
+        {
+            return total == static_cast<unsigned __int128>(count) << fractionBits;
+        }
+
+        void save(std::ostream& out) const
+        {
+            out << static_cast<uint64_t>(total >> wordBits) << ' ' << static_cast<uint64_t>(total) << ' ';
+        }
+
+        bool load(std::istream& in)
+        {
+            uint64_t high = 0;
+            uint64_t low = 0;
+            in >> high >> low;
+            total = (static_cast<unsigned __int128>(high) << wordBits) | low;
+            return static_cast<bool>(in);
+        }
+
+        bool operator==(const FixedSum& rhs) const = default;
+};
+
+template <int_fast16_t maxValue>
+std::ostream& operator<<(std::ostream& lhs, const Histogram<maxValue>& rhs)
+{
+    return lhs << "mean " << rhs.mean() << ", variance " << rhs.variance()
+               << ", p10 " << rhs.quantile(0.1) << ", median " << rhs.quantile(0.5) << ", p90 " << rhs.quantile(0.9);
+}
+
+// Weighted estimates from fewer effective games than this fraction of the
+// games are reported as unreliable
+inline constexpr double minEffectiveFraction = 0.1;
+
+class GameStatistics
+{
+    friend std::ostream& operator<<(std::ostream& lhs, const GameStatistics& rhs)
+    {
+        std::stringstream result{};
+        result << std::setprecision(10);
+        // Counts and histograms of importance sampled games describe the
+        // biased sample, not unbiased play
+        const char* sample = rhs.isUnweighted() ? "" : " (biased sample)";
+        result << "Games: " << rhs.games() << '\n';
+        for (int_fast16_t outcome = static_cast<int_fast16_t>(Outcome::won); outcome < numOutcomes; ++outcome)
+        {
+            result << outcomeNames[outcome] << sample << ": " << rhs.outcomes[outcome] << '\n';
+        }
+        result << "Turns" << sample << ": " << rhs.turns << '\n';
+        result << "Outbreaks" << sample << ": " << rhs.outbreaks << '\n';
+        result << "Epidemics" << sample << ": " << rhs.epidemics << '\n';
+        if (!rhs.isUnweighted())
+        {
+            result << "Likelihood ratio: mean " << rhs.totalWeight().value() / rhs.games() << ", effective sample size " << rhs.effectiveSampleSize() << '\n';
+            if (rhs.effectiveSampleSize() < minEffectiveFraction * rhs.games())
+                result << "Warning: the effective sample size has collapsed, weighted estimates are unreliable\n";
+            for (int_fast16_t outcome = static_cast<int_fast16_t>(Outcome::won); outcome < numOutcomes; ++outcome)
+            {
+                double effective = rhs.effectiveSampleSize(static_cast<Outcome>(outcome));
+                result << "Weighted " << outcomeNames[outcome] << ": probability " << rhs.probability(static_cast<Outcome>(outcome))
+                       << ", standard error " << rhs.standardError(static_cast<Outcome>(outcome)) << ", effective sample size " << effective
+                       << (effective < minEffectiveFraction * rhs.outcomes[outcome] ? " (collapsed, unreliable)" : "") << '\n';
+            }
+        }
+        return lhs << result.str();
+    }
+
+    private:
+
+        std::array<uint_fast64_t, numOutcomes> outcomes{};
+        Histogram<maxTurns> turns;
+        Histogram<maxOutbreaks + 1> outbreaks;
+        Histogram<gameDifficulty> epidemics;
+        std::array<FixedSum, numOutcomes> weights{};
+        std::array<FixedSum, numOutcomes> squaredWeights{};
+
+        FixedSum totalWeight() const noexcept
+        {
+            FixedSum result;
+            for (const FixedSum& weight : weights)
+            {
+                result.merge(weight);
+            }
+            return result;
+        }
+
+        static double effectiveSampleSize(const FixedSum& weight, const FixedSum& squaredWeight) noexcept
+        {
+            return squaredWeight.value() == 0.0 ? 0.0 : weight.value() * weight.value() / squaredWeight.value();
+        }
+
+    public:
+
+        void add(const GameResult& result) noexcept
+        {
+            ++outcomes[static_cast<int_fast16_t>(result.outcome)];
+            weights[static_cast<int_fast16_t>(result.outcome)].add(result.likelihoodRatio);
+            squaredWeights[static_cast<int_fast16_t>(result.outcome)].add(result.likelihoodRatio * result.likelihoodRatio);
+            turns.add(result.turns);
+            outbreaks.add(result.outbreaks);
+            epidemics.add(result.epidemics);
+        }
+
+        void merge(const GameStatistics& rhs) noexcept
+        {
+            for (int_fast16_t outcome = 0; outcome < numOutcomes; ++outcome)
+            {
+                outcomes[outcome] += rhs.outcomes[outcome];
+                weights[outcome].merge(rhs.weights[outcome]);
+                squaredWeights[outcome].merge(rhs.squaredWeights[outcome]);
+            }
+            turns.merge(rhs.turns);
+            outbreaks.merge(rhs.outbreaks);
+            epidemics.merge(rhs.epidemics);
+        }
+
+        uint_fast64_t games() const noexcept
+        {
+            return turns.count();
+        }
+
+        uint_fast64_t outcomeCount(Outcome outcome) const noexcept
+        {
+            return outcomes[static_cast<int_fast16_t>(outcome)];
+        }
+
+        // True unless the games were importance sampled
+        bool isUnweighted() const noexcept
+        {
+            return totalWeight().equalsCount(games());
+        }
+
+        // Importance-weighted estimate of the probability of an outcome under unbiased play
+        double probability(Outcome outcome) const noexcept
+        {
+            return games() == 0 ? 0.0 : weights[static_cast<int_fast16_t>(outcome)].value() / games();
+        }
+
+        double standardError(Outcome outcome) const noexcept
+        {
+            uint_fast64_t n = games();
+            if (n < 2)
+                return 0.0;
+            double estimate = probability(outcome);
+            double secondMoment = squaredWeights[static_cast<int_fast16_t>(outcome)].value() / n;
+            return std::sqrt(std::max(0.0, secondMoment - estimate * estimate) / (n - 1));
+        }
+
+        // Number of unweighted games that would give estimates as precise,
+        // (sum of weights)^2 / (sum of squared weights). Equals the number of
+        // games without a bias and drops as a few weights come to dominate.
+        double effectiveSampleSize() const noexcept
+        {
+            FixedSum squaredWeight;
+            for (const FixedSum& squared : squaredWeights)
+            {
+                squaredWeight.merge(squared);
+            }
+            return effectiveSampleSize(totalWeight(), squaredWeight);
+        }
+
+        // Effective sample size of the games that ended in an outcome
+        double effectiveSampleSize(Outcome outcome) const noexcept
+        {
+            return effectiveSampleSize(weights[static_cast<int_fast16_t>(outcome)], squaredWeights[static_cast<int_fast16_t>(outcome)]);
+        }
+
+        const Histogram<maxTurns>& getTurns() const noexcept
+        {
+            return turns;
+        }
+
+        const Histogram<maxOutbreaks + 1>& getOutbreaks() const noexcept
+        {
+            return outbreaks;
+        }
+
+        void save(std::ostream& out) const
+        {
+            for (uint_fast64_t count : outcomes)
+            {
+                out << count << ' ';
+            }
+            turns.save(out);
+            outbreaks.save(out);
+            epidemics.save(out);
+            for (int_fast16_t outcome = 0; outcome < numOutcomes; ++outcome)
+            {
+                weights[outcome].save(out);
+                squaredWeights[outcome].save(out);
+            }
+            out << '\n';
+        }
+
+        bool load(std::istream& in)
+        {
+            for (uint_fast64_t& count : outcomes)
+            {
+                in >> count;
+            }
+            if (!turns.load(in) || !outbreaks.load(in) || !epidemics.load(in))
+                return false;
+            for (int_fast16_t outcome = 0; outcome < numOutcomes; ++outcome)
+            {
+                if (!weights[outcome].load(in) || !squaredWeights[outcome].load(in))
+                    return false;
+            }
+            return true;
+        }
+
+        bool operator==(const GameStatistics& rhs) const = default;
+};
+#endif
@@ -1,7 +1,871 @@
-#include "game.h"
+#include "batch.h"
+#include "pandemic.h"
+#include "server.h"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <vector>
 
-int main(int argc, char *argv[]) 
+inline int_fast32_t failures = 0;
+inline constexpr uint_fast64_t sampleGames = 20000;
+
+inline void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        ++failures;
+        std::cout << "FAILED: " << message << '\n';
+    }
+}
+
+// Upper 0.1% point of the chi-square distribution (Wilson-Hilferty approximation)
+inline double chiSquareCritical(int_fast32_t degreesOfFreedom)
+{
+    constexpr double z = 3.0902;
+    double k = static_cast<double>(degreesOfFreedom);
+    double term = 1.0 - 2.0 / (9.0 * k) + z * std::sqrt(2.0 / (9.0 * k));
+    return k * term * term * term;
+}
+
+inline double chiSquare(const std::vector<int_fast64_t>& observed, const std::vector<double>& expected)
+{
+    double result = 0.0;
+    for (size_t i = 0; i < observed.size(); ++i)
+    {
+        double difference = static_cast<double>(observed[i]) - expected[i];
+        result += difference * difference / expected[i];
+    }
+    return result;
+}
+
+inline void checkUniform(const std::vector<int_fast64_t>& observed, const std::string& message)
+{
+    int_fast64_t total = std::accumulate(observed.begin(), observed.end(), int_fast64_t{0});
+    std::vector<double> expected(observed.size(), static_cast<double>(total) / observed.size());
+    double statistic = chiSquare(observed, expected);
+    std::stringstream description{};
+    description << message << " (chi-square " << statistic << ")";
+    check(statistic < chiSquareCritical(observed.size() - 1), description.str());
+}
+
+// Two-sample Kolmogorov-Smirnov statistic
+inline double ksStatistic(std::vector<double> a, std::vector<double> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    double result = 0.0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        double value = std::min(a[i], b[j]);
+        while (i < a.size() && a[i] == value)
+            ++i;
+        while (j < b.size() && b[j] == value)
+            ++j;
+        double difference = std::abs(static_cast<double>(i) / a.size() - static_cast<double>(j) / b.size());
+        result = std::max(result, difference);
+    }
+    return result;
+}
+
+// Rejects at the 0.1% level that both samples were drawn from the same distribution
+inline void compareDistributions(const std::vector<double>& reference, const std::vector<double>& candidate, const std::string& message)
+{
+    double n = static_cast<double>(reference.size());
+    double m = static_cast<double>(candidate.size());
+    double statistic = ksStatistic(reference, candidate);
+    std::stringstream description{};
+    description << message << " (KS " << statistic << ")";
+    check(statistic < 1.949 * std::sqrt((n + m) / (n * m)), description.str());
+}
+
+// Draw positions of the epidemic cards still in the player deck, counted from the top
+template <int_fast64_t roles>
+std::vector<int_fast16_t> epidemicDepths(const Game<roles>& game)
+{
+    std::vector<int_fast16_t> result;
+    const playerDeck& deck = game.getPlayerDeck();
+    for (int_fast16_t index = deck.getDrawIndex(); index >= 0; --index)
+    {
+        if (deck.getCards()[index].template getNumber<int_fast16_t>() == epidemicCard)
+            result.push_back(deck.getDrawIndex() - index);
+    }
+    return result;
+}
+
+inline double smallestGap(const std::vector<int_fast16_t>& depths)
+{
+    int_fast16_t result = numPlayerCards + gameDifficulty;
+    for (size_t i = 1; i < depths.size(); ++i)
+    {
+        result = std::min<int_fast16_t>(result, depths[i] - depths[i - 1]);
+    }
+    return static_cast<double>(result);
+}
+
+void testDeckContents()
+{
+    for (uint_fast64_t seed = 0; seed < 1000; ++seed)
+    {
+        Game<0> game{seed};
+        std::array<int_fast16_t, numPlayerCards> playerCounts{};
+        int_fast16_t epidemics = 0;
+        for (const playerCard& card : game.getPlayerDeck().getCards())
+        {
+            int_fast16_t number = card.getNumber<int_fast16_t>();
+            if (number == epidemicCard)
+                ++epidemics;
+            else
+                ++playerCounts[number];
+        }
+        check(epidemics == gameDifficulty, "player deck holds one epidemic per difficulty level");
+        check(std::all_of(playerCounts.begin(), playerCounts.end(), [](int_fast16_t c){ return c == 1; }), "player deck holds every city and event card once");
+
+        std::array<int_fast16_t, numCityCards> infectionCounts{};
+        const auto& infectionCards = game.getInfectionDeck().getCards();
+        for (auto begin = infectionCards.begin(), end = infectionCards.begin() + numCityCards; begin != end; ++begin)
+        {
+            ++infectionCounts[begin->getNumber<int_fast16_t>()];
+        }
+        check(std::all_of(infectionCounts.begin(), infectionCounts.end(), [](int_fast16_t c){ return c == 1; }), "infection deck holds every city once");
+        check(game.getInfectionDeck().getDrawIndex() == numCityCards - numWaves * citiesPerWave - 1, "initial infections draw nine cards");
+    }
+}
+
+void testEpidemicPlacement()
+{
+    for (uint_fast64_t seed = 0; seed < 1000; ++seed)
+    {
+        Game<0> game{seed};
+        const playerDeck& deck = game.getPlayerDeck();
+        std::array<int_fast16_t, gameDifficulty> deckSizes = deck.getDeckSizes();
+        check(std::accumulate(deckSizes.begin(), deckSizes.end(), int_fast16_t{0}) == deck.getDrawIndex() + 1, "piles cover the whole player deck");
+        int_fast16_t pileTop = deck.getDrawIndex();
+        for (int_fast16_t pile = gameDifficulty - 1; pile >= 0; --pile)
+        {
+            int_fast16_t epidemics = 0;
+            for (int_fast16_t index = pileTop; index > pileTop - deckSizes[pile]; --index)
+            {
+                if (deck.getCards()[index].getNumber<int_fast16_t>() == epidemicCard)
+                    ++epidemics;
+            }
+            check(epidemics == 1, "each pile holds exactly one epidemic");
+            pileTop -= deckSizes[pile];
+        }
+    }
+}
+
+void testCubeTotals()
+{
+    for (uint_fast64_t seed = 0; seed < 1000; ++seed)
+    {
+        Game<0> game{seed};
+        int_fast16_t cubesPlaced = 0;
+        for (int_fast16_t color = 0; color < numDiseases; ++color)
+        {
+            int_fast16_t onBoard = 0;
+            for (const City& city : game.getCities())
+            {
+                onBoard += city.getInfectionCount(static_cast<Color>(color));
+            }
+            cubesPlaced += onBoard;
+            check(onBoard + game.getDiseases()[color].getCubesLeft() == diseaseCubesPerColor, "disease cubes are conserved");
+        }
+        check(cubesPlaced == citiesPerWave * (strongestWave * (strongestWave + 1) / 2), "initial infections place eighteen cubes");
+    }
+}
+
+void testCityConnections()
+{
+    for (int_fast16_t city = 0; city < numCities; ++city)
+    {
+        for (Cities neighbor : cityConnections[city])
+        {
+            check(static_cast<int_fast16_t>(neighbor) != city, "cities are not connected to themselves");
+            check(cityConnections[static_cast<int_fast16_t>(neighbor)].count(static_cast<Cities>(city)) == 1, "city connections are symmetric");
+        }
+    }
+}
+
+void testPlayedGames()
+{
+    for (uint_fast64_t seed = 0; seed < 1000; ++seed)
+    {
+        Game<0> game{seed};
+        GameResult result = game.play();
+        check(result.outcome != Outcome::ongoing, "played games are decided");
+        check(result.outbreaks <= maxOutbreaks + 1, "games stop at the losing outbreak");
+        check(result.epidemics <= gameDifficulty, "no more epidemics than the difficulty");
+        for (int_fast16_t color = 0; color < numDiseases; ++color)
+        {
+            int_fast16_t onBoard = 0;
+            for (const City& city : game.getCities())
+            {
+                int_fast16_t count = city.getInfectionCount(static_cast<Color>(color));
+                check(count <= maxInfection - 1, "cities hold at most three cubes of a color");
+                onBoard += count;
+            }
+            check(onBoard + game.getDiseases()[color].getCubesLeft() == diseaseCubesPerColor, "disease cubes are conserved through play");
+            check(game.getDiseases()[color].getCubesLeft() >= 0 || result.outcome == Outcome::cubeLoss, "running out of cubes loses the game");
+        }
+    }
+}
+
+void testStatisticsMerge()
+{
+    GameStatistics whole;
+    std::array<GameStatistics, 3> parts;
+    for (uint_fast64_t seed = 0; seed < 3000; ++seed)
+    {
+        GameResult result = Game<0>{seed}.play();
+        whole.add(result);
+        parts[seed % parts.size()].add(result);
+    }
+    GameStatistics merged;
+    for (auto part = parts.rbegin(); part != parts.rend(); ++part)
+    {
+        merged.merge(*part);
+    }
+    check(merged == whole, "merged statistics match a single pass");
+    check(whole.games() == 3000, "statistics count every game");
+
+    std::stringstream oneThread{};
+    std::stringstream threeThreads{};
+    oneThread << runGames<0>(0, 3 * gamesPerChunk + 5, 1);
+    threeThreads << runGames<0>(0, 3 * gamesPerChunk + 5, 3);
+    check(oneThread.str() == threeThreads.str(), "summaries do not depend on the thread count");
+}
+
+void testCheckpointResume()
+{
+    constexpr uint_fast64_t games = 4 * gamesPerChunk + 17;
+    GameStatistics uninterrupted = runGames<0>(7, games, 2);
+
+    // A run stopped after its first and third chunks
+    Checkpoint stopped{7, games};
+    for (uint_fast64_t chunk : {0, 2})
+    {
+        auto [begin, end] = stopped.chunkGames(chunk);
+        stopped.complete(chunk, runGames<0>(7 + begin, end - begin, 1));
+    }
+    std::stringstream saved{};
+    stopped.save(saved);
+
+    Checkpoint resumed{7, games};
+    check(resumed.load(saved), "checkpoints load back");
+    check(resumed.isCompleted(0) && !resumed.isCompleted(1) && resumed.isCompleted(2), "checkpoints keep the completed chunks");
+    check(resumed.statistics == stopped.statistics, "checkpoints keep the statistics");
+    runGames<0>(resumed, 3);
+    check(resumed.statistics == uninterrupted, "resumed runs match uninterrupted runs");
+
+    std::stringstream otherRun{};
+    stopped.save(otherRun);
+    Checkpoint mismatched{8, games};
+    check(!mismatched.load(otherRun), "checkpoints of other runs are rejected");
+
+    std::stringstream greedyRun{};
+    Checkpoint{7, games, GreedyPolicy::name}.save(greedyRun);
+    Checkpoint passive{7, games};
+    check(!passive.load(greedyRun), "checkpoints of other policies are rejected");
+
+    SamplingBias bias;
+    bias.epidemicTilts = {-0.75, 0.1, 0.0, 2.0 / 3.0};
+    std::stringstream biasedRun{};
+    Checkpoint{7, games, PassivePolicy::name, bias}.save(biasedRun);
+    std::string biasedText = biasedRun.str();
+    Checkpoint sameBias{7, games, PassivePolicy::name, bias};
+    check(sameBias.load(biasedRun), "biased checkpoints load back");
+    std::stringstream reread{biasedText};
+    check(!passive.load(reread), "checkpoints of other biases are rejected");
+}
+
+void testShards()
+{
+    constexpr uint_fast64_t games = 2 * gamesPerChunk + 3;
+    constexpr uint_fast64_t shards = 5;
+    GameStatistics whole = runGames<0>(11, games, 1);
+    std::vector<ShardResult> results;
+    uint_fast64_t nextSeed = 11;
+    for (uint_fast64_t shard = shards; shard-- > 0;)
+    {
+        auto [firstSeed, shardGames] = shardRange(11, games, shard, shards);
+        auto [nextFirstSeed, nextGames] = shardRange(11, games, shard + 1, shards);
+        check(shard + 1 == shards || firstSeed + shardGames == nextFirstSeed, "shards are contiguous");
+        nextSeed = firstSeed;
+        ShardResult result{firstSeed, shardGames, runGames<0>(firstSeed, shardGames, 2), 11, games, PassivePolicy::name, SamplingBias{}};
+        std::stringstream file{};
+        result.save(file);
+        ShardResult loaded;
+        check(loaded.load(file) && loaded.statistics == result.statistics, "shard results load back");
+        results.push_back(loaded);
+    }
+    check(nextSeed == 11, "shards start at the first seed");
+
+    std::optional<ShardResult> merged = mergeResults(results);
+    check(merged && merged->firstSeed == 11 && merged->games == games, "merged shards cover the whole run");
+    check(merged && merged->statistics == whole, "merged shards match a single process");
+
+    // Results are in reverse shard order, the front is the last shard
+    std::vector<ShardResult> withoutLast{results.begin() + 1, results.end()};
+    check(!mergeResults(withoutLast), "merging refuses a missing last shard");
+    std::vector<ShardResult> withoutFirst{results.begin(), results.end() - 1};
+    check(!mergeResults(withoutFirst), "merging refuses a missing first shard");
+    std::vector<ShardResult> otherRun{results};
+    otherRun.front().totalGames += 1;
+    check(!mergeResults(otherRun), "merging refuses shards of other runs");
+    std::vector<ShardResult> otherPolicy{results};
+    otherPolicy.back().policy = GreedyPolicy::name;
+    check(!mergeResults(otherPolicy), "merging refuses shards of other policies");
+    std::vector<ShardResult> otherBias{results};
+    otherBias.back().bias.epidemicTilts.fill(-1.0);
+    check(!mergeResults(otherBias), "merging refuses shards of other biases");
+    results.erase(results.begin() + 2);
+    check(!mergeResults(results), "merging refuses missing shards");
+    results.push_back(results.front());
+    check(!mergeResults(results), "merging refuses overlapping shards");
+}
+
+inline constexpr int_fast64_t scientists = static_cast<int_fast64_t>('S' << 24) + static_cast<int_fast64_t>('S' << 16) + static_cast<int_fast64_t>('S' << 8) + static_cast<int_fast64_t>('S');
+
+bool sameResult(const GameResult& lhs, const GameResult& rhs)
+{
+    return lhs.outcome == rhs.outcome && lhs.turns == rhs.turns && lhs.outbreaks == rhs.outbreaks && lhs.epidemics == rhs.epidemics;
+}
+
+void testPolicies()
+{
+    auto greedyAgent = std::make_shared<PolicyAgent<scientists, GreedyPolicy>>();
+    int_fast16_t cures = 0;
+    for (uint_fast64_t seed = 0; seed < 1000; ++seed)
+    {
+        Game<scientists, GreedyPolicy> greedy{seed};
+        GameResult result = greedy.play();
+        Game<scientists, RuntimePolicy<scientists>> runtime{seed, RuntimePolicy<scientists>{greedyAgent}};
+        check(sameResult(runtime.play(), result), "runtime adapter matches the inlined greedy policy");
+        check(sameResult(Game<scientists, RuntimePolicy<scientists>>{seed}.play(), Game<scientists>{seed}.play()), "runtime adapter matches the inlined passive policy");
+
+        for (int_fast16_t color = 0; color < numDiseases; ++color)
+        {
+            int_fast16_t onBoard = 0;
+            for (const City& city : greedy.getCities())
+            {
+                onBoard += city.getInfectionCount(static_cast<Color>(color));
+            }
+            check(onBoard + greedy.getDiseases()[color].getCubesLeft() == diseaseCubesPerColor, "disease cubes are conserved while treating");
+            cures += greedy.isCured(static_cast<Color>(color));
+        }
+        for (const Player& player : greedy.getPlayers())
+        {
+            check(static_cast<int_fast16_t>(player.getCards().count()) <= maxCards, "hands respect the card limit");
+            check(player.getRole() == Roles::scientist, "players take the roles of the template argument");
+        }
+    }
+    check(cures > 0, "the greedy policy discovers cures");
+}
+
+// Experimental agents behind the runtime adapter may name cities, colors and
+// players that do not exist
+class OutOfRangeAgent : public Agent<scientists>
+{
+    private:
+
+        int_fast16_t decisions{0};
+
+    public:
+
+        Action chooseAction(const Game<scientists, RuntimePolicy<scientists>>&, int_fast16_t)
+        {
+            constexpr std::array<Action, 4> actions
+            {
+                Action{ActionType::directFlight, static_cast<Cities>(numCities)},
+                Action{ActionType::drive, static_cast<Cities>(-1)},
+                Action{ActionType::treat, Cities::atlanta, static_cast<Color>(7)},
+                Action{ActionType::discoverCure, Cities::atlanta, static_cast<Color>(-3)}
+            };
+            return actions[decisions++ % actions.size()];
+        }
+
+        playerCard chooseDiscard(const Game<scientists, RuntimePolicy<scientists>>&, int_fast16_t)
+        {
+            return playerCard{static_cast<int_fast16_t>(numPlayerCards + decisions++)};
+        }
+
+        std::optional<EventPlay> chooseEvent(const Game<scientists, RuntimePolicy<scientists>>&)
+        {
+            constexpr std::array<EventPlay, 3> events
+            {
+                EventPlay{Events::airlift, 0, static_cast<Cities>(200)},
+                EventPlay{Events::governmentGrant, numPlayers, Cities::atlanta},
+                EventPlay{static_cast<Events>(numPlayerCards), 0, Cities::atlanta}
+            };
+            return events[decisions++ % events.size()];
+        }
+};
+
+void testOutOfRangeDecisions()
+{
+    Game<scientists> game{0};
+    check(!game.isLegal(Action{ActionType::directFlight, static_cast<Cities>(numCities)}, 0), "direct flights to cities past the board are illegal");
+    check(!game.isLegal(Action{ActionType::treat, Cities::atlanta, static_cast<Color>(7)}, 0), "treating unknown colors is illegal");
+    check(!game.isLegal(EventPlay{Events::airlift, 0, static_cast<Cities>(200)}), "airlifts past the board are illegal");
+    auto agent = std::make_shared<OutOfRangeAgent>();
+    for (uint_fast64_t seed = 0; seed < 200; ++seed)
+    {
+        Game<scientists, RuntimePolicy<scientists>> runtime{seed, RuntimePolicy<scientists>{agent}};
+        GameResult result = runtime.play();
+        check(sameResult(result, Game<scientists>{seed}.play()), "out of range decisions change nothing");
+        for (const Player& player : runtime.getPlayers())
+        {
+            check(static_cast<int_fast16_t>(player.getLocation()) >= 0 && static_cast<int_fast16_t>(player.getLocation()) < numCities
+                  , "players stay on the board");
+        }
+    }
+}
+
+// Work that fails to be handed to its third thread
+struct FailingWork
+{
+    std::atomic<int_fast16_t>* copies;
+    std::atomic<int_fast16_t>* runs;
+
+    FailingWork(std::atomic<int_fast16_t>* c, std::atomic<int_fast16_t>* r)
+        : copies{c}, runs{r}
+    {}
+
+    FailingWork(const FailingWork& rhs)
+        : copies{rhs.copies}, runs{rhs.runs}
+    {
+        if (++*copies == 3)
+            throw std::runtime_error{"thread not started"};
+    }
+
+    void operator()() const
+    {
+        ++*runs;
+    }
+};
+
+void testThreadStartFailure()
+{
+    std::atomic<int_fast16_t> copies{0};
+    std::atomic<int_fast16_t> runs{0};
+    bool thrown = false;
+    try
+    {
+        runOnThreads(4, FailingWork{&copies, &runs});
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    check(thrown && runs == copies - 1, "threads started before a failed start are joined");
+    runs = 0;
+    runOnThreads(0, [&](){ ++runs; });
+    check(runs == 1, "work runs on at least one thread");
+}
+
+void testLibrary()
+{
+    constexpr size_t games = gamesPerChunk + 100;
+    std::vector<pandemic_result> results(games);
+    pandemic_config config{1000, PANDEMIC_POLICY_GREEDY, 3, {}};
+    check(pandemic_run_batch(&config, results.data(), games) == PANDEMIC_OK, "the library runs batches");
+    for (size_t game = 0; game < games; game += 97)
+    {
+        GameResult expected = Game<defaultRoles, GreedyPolicy>{1000 + game}.play();
+        const pandemic_result& result = results[game];
+        check(result.seed == 1000 + game && result.outcome == static_cast<int16_t>(expected.outcome) && result.turns == expected.turns
+              && result.outbreaks == expected.outbreaks && result.epidemics == expected.epidemics, "library results match the engine");
+    }
+    // More threads than any fast integer of 16 bits holds
+    config.threads = 1 << 16;
+    std::fill(results.begin(), results.end(), pandemic_result{});
+    check(pandemic_run_batch(&config, results.data(), games) == PANDEMIC_OK, "the library runs batches on many threads");
+    check(std::all_of(results.begin(), results.end(), [&](const pandemic_result& result){ return result.seed == 1000 + static_cast<uint64_t>(&result - results.data()); })
+          , "batches on many threads fill every result");
+    config.epidemic_tilts[0] = 2 * maxEpidemicTilt;
+    check(pandemic_run_batch(&config, results.data(), games) == PANDEMIC_INVALID_ARGUMENT, "the library rejects out of range tilts");
+    config.epidemic_tilts[0] = 0.0;
+    config.policy = 7;
+    check(pandemic_run_batch(&config, results.data(), games) == PANDEMIC_INVALID_ARGUMENT, "the library rejects unknown policies");
+    check(pandemic_run_batch(nullptr, results.data(), games) == PANDEMIC_INVALID_ARGUMENT, "the library rejects a missing config");
+}
+
+void testImportanceSampling()
+{
+    SamplingBias bias;
+    bias.epidemicTilts.fill(-maxEpidemicTilt);
+    GameStatistics weighted;
+    std::array<GameStatistics, 2> parts;
+    GameStatistics plain;
+    double weightedDepth = 0.0;
+    double squaredWeightedDepth = 0.0;
+    for (uint_fast64_t seed = 0; seed < sampleGames; ++seed)
+    {
+        Game<0> unbiased{seed, PassivePolicy{}, SamplingBias{}};
+        check(unbiased.getResult().likelihoodRatio == 1.0 && sameResult(unbiased.play(), Game<0>{seed}.play()), "an empty bias plays unbiased games");
+
+        Game<0> biased{seed, PassivePolicy{}, bias};
+        double likelihoodRatio = biased.getResult().likelihoodRatio;
+        double depth = likelihoodRatio * epidemicDepths(biased).front();
+        weightedDepth += depth;
+        squaredWeightedDepth += depth * depth;
+        GameResult result = biased.play();
+        weighted.add(result);
+        parts[seed % parts.size()].add(result);
+        plain.add(Game<0>{sampleGames + seed}.play());
+    }
+    GameStatistics merged = parts[1];
+    merged.merge(parts[0]);
+    check(merged == weighted, "weighted statistics merge exactly");
+    check(plain.isUnweighted() && !weighted.isUnweighted(), "only biased runs are weighted");
+
+    // The first epidemic is uniform over the top pile without the bias
+    double pileSize = Game<0>{0}.getPlayerDeck().getDeckSizes().back();
+    double mean = weightedDepth / sampleGames;
+    double standardError = std::sqrt((squaredWeightedDepth / sampleGames - mean * mean) / sampleGames);
+    check(std::abs(mean - (pileSize - 1) / 2) < 4 * standardError, "weighted epidemic positions are unbiased");
+
+    for (Outcome outcome : {Outcome::outbreakLoss, Outcome::cubeLoss})
+    {
+        double difference = weighted.probability(outcome) - plain.probability(outcome);
+        double combinedError = std::hypot(weighted.standardError(outcome), plain.standardError(outcome));
+        std::stringstream description{};
+        description << "weighted " << outcomeNames[static_cast<int_fast16_t>(outcome)] << " probability matches unbiased play (difference " << difference << ")";
+        check(std::abs(difference) < 4 * combinedError, description.str());
+    }
+    check(plain.effectiveSampleSize() == sampleGames, "unweighted games are all effective");
+    check(weighted.effectiveSampleSize() > 0.6 * sampleGames && weighted.effectiveSampleSize() < sampleGames
+          , "the largest tilts keep most of the sample effective");
+    std::stringstream summary{};
+    summary << weighted;
+    check(summary.str().find("effective sample size") != std::string::npos, "weighted summaries report the effective sample size");
+}
+
+// Every epidemic in the bottom quarter of its pile, the late epidemics that
+// lengthen games, is rare without the bias
+bool lateEpidemics(const Game<0>& game, double& probability)
+{
+    std::array<int_fast16_t, gameDifficulty> deckSizes = game.getPlayerDeck().getDeckSizes();
+    std::vector<int_fast16_t> depths = epidemicDepths(game);
+    bool late = true;
+    int_fast16_t pileTop = 0;
+    probability = 1.0;
+    for (int_fast16_t pile = 0; pile < gameDifficulty; ++pile)
+    {
+        int_fast16_t pileSize = deckSizes[gameDifficulty - 1 - pile];
+        int_fast16_t quarter = pileSize / 4;
+        late = late && depths[pile] - pileTop >= pileSize - quarter;
+        probability *= static_cast<double>(quarter) / pileSize;
+        pileTop += pileSize;
+    }
+    return late;
+}
+
+void testVarianceReduction()
+{
+    SamplingBias bias;
+    bias.epidemicTilts.fill(maxEpidemicTilt);
+    double probability = 0.0;
+    double sum = 0.0;
+    double squaredSum = 0.0;
+    for (uint_fast64_t seed = 0; seed < sampleGames; ++seed)
+    {
+        Game<0> biased{seed, PassivePolicy{}, bias};
+        double estimate = lateEpidemics(biased, probability) ? biased.getResult().likelihoodRatio : 0.0;
+        sum += estimate;
+        squaredSum += estimate * estimate;
+    }
+    double mean = sum / sampleGames;
+    double variance = squaredSum / sampleGames - mean * mean;
+    check(std::abs(mean - probability) < 4 * std::sqrt(variance / sampleGames), "weighted late epidemics are unbiased");
+    check(variance < 0.5 * probability * (1 - probability), "tilting toward late epidemics halves the variance of their estimate");
+}
+
+uint16_t lowestCard(uint64_t hand)
+{
+    return hand == 0 ? numPlayerCards : static_cast<uint16_t>(std::countr_zero(hand));
+}
+
+bool isLegalIndex(const Observation& observation, uint16_t index)
+{
+    return observation.legal[index / bitsInByte] >> (index % bitsInByte) & 1;
+}
+
+// Passing every action and discarding the lowest card is the passive policy
+void testStepServer()
+{
+    constexpr uint32_t environments = 200;
+    StepServer<scientists> server;
+    std::vector<Observation> observations;
+    for (uint32_t environment = 0; environment < environments; ++environment)
+    {
+        observations.push_back(server.handle(StepRequest{environment, environment, 0, Operation::reset, 0}));
+    }
+    for (bool running = true; running;)
+    {
+        running = false;
+        for (Observation& observation : observations)
+        {
+            if (observation.decision == Decision::none)
+                continue;
+            running = true;
+            uint16_t action = passAction;
+            uint64_t hand = observation.hands[observation.player];
+            if (observation.decision == Decision::discard)
+            {
+                action = lowestCard(hand);
+                check(std::popcount(hand) > maxCards, "discards are asked only over the hand limit");
+                for (uint16_t card = 0; card < numPlayerCards; ++card)
+                {
+                    check(isLegalIndex(observation, card) == (hand >> card & 1), "the discard mask is the hand");
+                }
+            }
+            else
+                check(isLegalIndex(observation, passAction), "passing is always legal");
+            if (observation.decision == Decision::action)
+            {
+                uint16_t card = lowestCard(hand);
+                if (card < numCities)
+                    check(isLegalIndex(observation, directFlightActions + card) == (observation.locations[observation.player] != card), "direct flights are legal to the cities in hand");
+                check(!isLegalIndex(observation, directFlightActions + observation.locations[observation.player]), "there is no direct flight to the current city");
+            }
+            observation = server.handle(StepRequest{0, observation.environment, action, Operation::step, 0});
+        }
+    }
+    for (const Observation& observation : observations)
+    {
+        GameResult expected = Game<scientists>{observation.environment}.play();
+        check(observation.outcome == static_cast<uint8_t>(expected.outcome) && observation.turn == expected.turns
+              && observation.outbreaks == expected.outbreaks && observation.epidemics == expected.epidemics, "stepped games match played games");
+        check(server.handle(StepRequest{0, observation.environment, 0, Operation::close, 0}).outcome == observation.outcome, "closing returns the final state");
+    }
+    check(server.handle(StepRequest{0, 0, 0, Operation::step, 0}).outcome == unknownEnvironment, "closed environments are unknown");
+
+    // One batched message over a socket
+    int sockets[2];
+    check(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0, "socket pair opens");
+    std::thread serving{[&]()
+    {
+        server.serve(sockets[1], sockets[1]);
+        ::shutdown(sockets[1], SHUT_WR);
+    }};
+    std::vector<StepRequest> requests;
+    for (uint32_t environment = 0; environment < environments; ++environment)
+    {
+        requests.push_back(StepRequest{environment, environment, 0, Operation::reset, 0});
+    }
+    uint32_t count = environments;
+    check(::write(sockets[0], &count, sizeof(count)) == sizeof(count)
+          && ::write(sockets[0], requests.data(), count * sizeof(StepRequest)) == static_cast<ssize_t>(count * sizeof(StepRequest)), "requests are sent");
+    ::shutdown(sockets[0], SHUT_WR);
+    std::vector<char> reply;
+    std::array<char, 4096> buffer;
+    for (ssize_t bytes = ::read(sockets[0], buffer.data(), buffer.size()); bytes > 0; bytes = ::read(sockets[0], buffer.data(), buffer.size()))
+    {
+        reply.insert(reply.end(), buffer.begin(), buffer.begin() + bytes);
+    }
+    serving.join();
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+    check(reply.size() == sizeof(count) + count * sizeof(Observation), "one observation is returned per request");
+    if (reply.size() == sizeof(count) + count * sizeof(Observation))
+    {
+        Observation last;
+        std::memcpy(&last, reply.data() + sizeof(count) + (count - 1) * sizeof(Observation), sizeof(Observation));
+        check(last.environment == environments - 1 && last.decision == Decision::action && last.turn == 1, "observations answer their requests in order");
+    }
+
+    // An oversized batch drops the connection before anything is allocated
+    check(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0, "socket pair opens");
+    count = maxStepBatch + 1;
+    check(::write(sockets[0], &count, sizeof(count)) == sizeof(count), "the oversized count is sent");
+    check(!server.serve(sockets[1], sockets[1]), "oversized batches are refused");
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+
+    // A regular file at the socket path is left alone
+    std::string keep{(std::filesystem::temp_directory_path() / "pandemic_tests.XXXXXX").string()};
+    int keepFile = ::mkstemp(keep.data());
+    check(keepFile >= 0 && ::write(keepFile, "keep", 4) == 4, "the file to keep is written");
+    ::close(keepFile);
+    check(!server.serveSocket(keep), "serving refuses to replace a regular file");
+    check(std::filesystem::is_regular_file(keep) && std::filesystem::file_size(keep) == 4, "the regular file is kept");
+    std::filesystem::remove(keep);
+
+    // A client that leaves before its reply does not take the server down
+    check(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0, "socket pair opens");
+    count = 1;
+    StepRequest reset{1, 1, 0, Operation::reset, 0};
+    check(::write(sockets[0], &count, sizeof(count)) == sizeof(count) && ::write(sockets[0], &reset, sizeof(reset)) == sizeof(reset), "the request is sent");
+    ::close(sockets[0]);
+    check(!server.serve(sockets[1], sockets[1]), "replies to closed connections fail");
+    ::close(sockets[1]);
+}
+
+bool sameSetup(const Game<scientists>& lhs, const Game<scientists>& rhs)
+{
+    for (int_fast16_t player = 0; player < numPlayers; ++player)
+    {
+        if (lhs.getPlayers()[player].getCards() != rhs.getPlayers()[player].getCards())
+            return false;
+    }
+    for (int_fast16_t city = 0; city < numCities; ++city)
+    {
+        for (int_fast16_t color = 0; color < numDiseases; ++color)
+        {
+            if (lhs.getCities()[city].getInfectionCount(static_cast<Color>(color)) != rhs.getCities()[city].getInfectionCount(static_cast<Color>(color)))
+                return false;
+        }
+    }
+    return lhs.getPlayerDeck().getDrawIndex() == rhs.getPlayerDeck().getDrawIndex() && lhs.getInfectionDeck().getDrawIndex() == rhs.getInfectionDeck().getDrawIndex()
+        && lhs.getResult().likelihoodRatio == rhs.getResult().likelihoodRatio;
+}
+
+void testSetupCache()
+{
+    constexpr uint_fast64_t firstSeed = 500;
+    constexpr uint_fast64_t games = 2000;
+    SamplingBias bias;
+    bias.epidemicTilts.fill(-maxEpidemicTilt);
+    std::string directory{(std::filesystem::temp_directory_path() / "pandemic_tests.XXXXXX").string()};
+    check(::mkdtemp(directory.data()) != nullptr, "the cache directory is created");
+    std::filesystem::path path = std::filesystem::path{directory} / "game.setup";
+    {
+        SetupCache cache{path, firstSeed, games, bias.epidemicTilts};
+        check(cache.isOpen(), "the setup cache opens");
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (uint_fast64_t seed = firstSeed - 14; seed < firstSeed + games + 14; seed += 7)
+            {
+                Game<scientists> cached{seed, cache};
+                Game<scientists> reference{seed, PassivePolicy{}, bias};
+                check(sameSetup(cached, reference), "cached setups match computed setups");
+                check(sameResult(cached.play(), reference.play()), "games from cached setups play like computed ones");
+            }
+        }
+        check(cache.lookup(firstSeed) != nullptr && cache.lookup(firstSeed + 1) == nullptr && cache.lookup(firstSeed + games) == nullptr
+              , "only the games set up are stored");
+    }
+    {
+        SetupCache reopened{path, firstSeed, games, bias.epidemicTilts};
+        check(reopened.lookup(firstSeed + 7) != nullptr, "stored setups persist");
+        check(!SetupCache(path, firstSeed + 1, games, bias.epidemicTilts).isOpen() && !SetupCache(path, firstSeed, games).isOpen()
+              , "a cache of other seeds or another bias is refused");
+
+        std::filesystem::path racedPath = std::filesystem::path{directory} / "raced.setup";
+        std::atomic<int_fast16_t> opened{0};
+        runOnThreads(8, [&]()
+        {
+            opened += SetupCache{racedPath, firstSeed, games, bias.epidemicTilts}.isOpen();
+        });
+        check(opened == 8, "caches created concurrently all open");
+        std::filesystem::remove(racedPath);
+
+        Checkpoint plain{firstSeed, games, PassivePolicy::name, bias};
+        runGames<scientists>(plain, 3);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            Checkpoint cached{firstSeed, games, PassivePolicy::name, bias};
+            runGames<scientists>(cached, 3, {}, 60.0, &reopened);
+            check(cached.statistics == plain.statistics, "runs from the setup cache match uncached runs");
+        }
+    }
+    {
+        // A repeated card and an impossible number of draws
+        std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+        file.seekp(sizeof(SetupCacheHeader) + offsetof(SetupRecord, playerCards) + 1);
+        file.put(static_cast<char>(SetupCache{path, firstSeed, games, bias.epidemicTilts}.lookup(firstSeed)->playerCards[0]));
+        uint64_t draws = maxSetupDraws + 1;
+        file.seekp(sizeof(SetupCacheHeader) + 7 * sizeof(SetupRecord) + offsetof(SetupRecord, draws));
+        file.write(reinterpret_cast<const char*>(&draws), sizeof(draws));
+        check(static_cast<bool>(file.flush()), "the cache file is damaged");
+    }
+    {
+        SetupCache damaged{path, firstSeed, games, bias.epidemicTilts};
+        check(damaged.lookup(firstSeed) == nullptr && damaged.lookup(firstSeed + 7) == nullptr, "damaged records are misses");
+        for (uint_fast64_t seed : {firstSeed, firstSeed + 7})
+        {
+            Game<scientists> recomputed{seed, damaged};
+            Game<scientists> reference{seed, PassivePolicy{}, bias};
+            check(sameSetup(recomputed, reference), "damaged records are recomputed");
+            check(damaged.lookup(seed) != nullptr, "damaged records are replaced");
+        }
+    }
+    std::filesystem::remove_all(directory);
+}
+
+void testShuffleDistributions()
+{
+    std::vector<int_fast64_t> firstInfection(numCityCards, 0);
+    std::vector<std::vector<int_fast64_t>> pilePositions;
+    std::vector<double> gaps;
+    std::array<int_fast16_t, gameDifficulty> deckSizes{};
+    for (uint_fast64_t seed = 0; seed < sampleGames; ++seed)
+    {
+        Game<0> game{seed};
+        ++firstInfection[game.getInfectionDeck().getCards()[numCityCards - 1].getNumber<int_fast16_t>()];
+        deckSizes = game.getPlayerDeck().getDeckSizes();
+        if (pilePositions.empty())
+        {
+            for (int_fast16_t pile = gameDifficulty - 1; pile >= 0; --pile)
+            {
+                pilePositions.emplace_back(deckSizes[pile], 0);
+            }
+        }
+        std::vector<int_fast16_t> depths = epidemicDepths(game);
+        int_fast16_t pileTop = 0;
+        for (int_fast16_t pile = 0; pile < gameDifficulty; ++pile)
+        {
+            ++pilePositions[pile][depths[pile] - pileTop];
+            pileTop += pilePositions[pile].size();
+        }
+        gaps.push_back(smallestGap(depths));
+    }
+    checkUniform(firstInfection, "first infected city is uniform");
+    for (const std::vector<int_fast64_t>& positions : pilePositions)
+    {
+        checkUniform(positions, "epidemic position is uniform within its pile");
+    }
+
+    // Reference model of the setup: one epidemic uniformly placed in each pile
+    std::mt19937_64 reference{0x5eed};
+    std::vector<double> referenceGaps;
+    for (uint_fast64_t game = 0; game < sampleGames; ++game)
+    {
+        std::vector<int_fast16_t> depths;
+        int_fast16_t pileTop = 0;
+        for (int_fast16_t pile = gameDifficulty - 1; pile >= 0; --pile)
+        {
+            std::uniform_int_distribution<int_fast16_t> position{0, static_cast<int_fast16_t>(deckSizes[pile] - 1)};
+            depths.push_back(pileTop + position(reference));
+            pileTop += deckSizes[pile];
+        }
+        referenceGaps.push_back(smallestGap(depths));
+    }
+    compareDistributions(referenceGaps, gaps, "epidemic clustering matches the reference model");
+}
+
+int main()
 {
-    Game<0> g{0};
-    return 0;
-}
\ No newline at end of file
+    testDeckContents();
+    testEpidemicPlacement();
+    testCubeTotals();
+    testCityConnections();
+    testPlayedGames();
+    testStatisticsMerge();
+    testCheckpointResume();
+    testShards();
+    testPolicies();
+    testOutOfRangeDecisions();
+    testThreadStartFailure();
+    testLibrary();
+    testImportanceSampling();
+    testVarianceReduction();
+    testStepServer();
+    testSetupCache();
+    testShuffleDistributions();
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}